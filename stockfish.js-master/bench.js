@@ -5,6 +5,43 @@ var assert = require("assert");
 var time;
 var timeEnd;
 
+/// Hash sizes (in MB) to measure the time to depth with, and that depth.
+var hashSizes = [16, 64, 256, 1024];
+var hashDepth = Number(process.argv[3]) || 18;
+var hashFen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10";
+
+/// Searches the same position from an empty table at each hash size in turn.
+function bench_hash(i)
+{
+    var hashfull = 0;
+    
+    if (i >= hashSizes.length) {
+        stockfish.send("quit");
+        return;
+    }
+    
+    stockfish.send("setoption name Hash value " + hashSizes[i]);
+    stockfish.send("ucinewgame");
+    stockfish.send("isready", function ()
+    {
+        stockfish.send("position fen " + hashFen);
+        time("Hash " + hashSizes[i] + " MB, go depth " + hashDepth);
+        stockfish.send("go depth " + hashDepth, function ongo()
+        {
+            timeEnd("Hash " + hashSizes[i] + " MB, go depth " + hashDepth);
+            console.log("  hashfull: %d permill", hashfull);
+            bench_hash(i + 1);
+        }, function thinking(str)
+        {
+            var match = str.match(/ hashfull (\d+)/);
+            
+            if (match) {
+                hashfull = Number(match[1]);
+            }
+        });
+    });
+}
+
 (function ()
 {
     var times = {};
@@ -50,7 +87,7 @@ stockfish.send("uci", function ()
                 //console.log("Stockfish says best move: " + str.match(/bestmove (\S+)/)[1]);
                 assert.equal(expectedMove, str.match(/bestmove (\S+)/)[1]);
                 assert.equal(expectedPonder, str.match(/ponder (\S+)/)[1]);
-                stockfish.send("quit");
+                bench_hash(0);
             }, function thinking(str)
             {
                 //console.log("thinking: " + str);
@@ -0,0 +1,76 @@
+#!/usr/bin/env node
+
+/// Compares the SMP schedulers of the native engine.
+///
+/// Runs the bench at a fixed depth for each scheduler and thread count and
+/// reports the time to reach that depth, the speed and the share of nodes that
+/// were new to the hash table, which drops when threads duplicate each other's
+/// work. The engine must be built with "make build ttstats=yes" for the last.
+///
+/// Usage: node smp_bench.js [engine] [--threads=1,2,4,...,256] [--schedulers=Skip Blocks,None,Depth Ratio,ABDADA]
+///                          [--ratio=50] [--hash=256] [--depth=16]
+
+"use strict";
+
+var spawnSync = require("child_process").spawnSync;
+var p = require("path");
+
+var engine = p.join(__dirname, "src", "stockfish");
+var threads = [1, 2, 4, 8, 16, 32, 64, 128, 256];
+var schedulers = ["Skip Blocks", "None", "Depth Ratio", "ABDADA"];
+var ratio = 50;
+var hash = 256;
+var depth = 16;
+
+process.argv.slice(2).forEach(function (arg)
+{
+    var match = arg.match(/^--(\w+)=(.*)$/);
+
+    if (!match) {
+        engine = arg;
+    } else if (match[1] === "threads") {
+        threads = match[2].split(",").map(Number);
+    } else if (match[1] === "schedulers") {
+        schedulers = match[2].split(",");
+    } else if (match[1] === "ratio") {
+        ratio = Number(match[2]);
+    } else if (match[1] === "hash") {
+        hash = Number(match[2]);
+    } else if (match[1] === "depth") {
+        depth = Number(match[2]);
+    }
+});
+
+function run_bench(scheduler, threadCount)
+{
+    var input = "setoption name SMP Scheduler value " + scheduler + "\n" +
+                "setoption name SMP Depth Ratio value " + ratio + "\n" +
+                "bench " + hash + " " + threadCount + " " + depth + " default depth\n" +
+                "quit\n";
+    ///NOTE: The "bench" command sends the final result in stderr.
+    var out = spawnSync(engine, [], {input: input}).stderr.toString(),
+        time = out.match(/Total time \(ms\)\s*:\s*(\d+)/),
+        nps = out.match(/Nodes\/second\s*:\s*(\d+)/),
+        unique = out.match(/Unique nodes\s*:\s*(\d+)/);
+
+    return {
+        time: time ? Number(time[1]) : 0,
+        nps: nps ? Number(nps[1]) : 0,
+        unique: unique ? Number(unique[1]) : 0
+    };
+}
+
+schedulers.forEach(function (scheduler)
+{
+    console.log(scheduler);
+
+    threads.forEach(function (threadCount)
+    {
+        var res = run_bench(scheduler, threadCount);
+
+        console.log("  threads " + threadCount +
+                    "  time to depth " + res.time + " ms" +
+                    "  nps " + res.nps +
+                    "  unique nodes " + (res.unique / 10).toFixed(1) + "%");
+    });
+});
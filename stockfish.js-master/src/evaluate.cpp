@@ -86,6 +86,10 @@ namespace {
 
   // Threshold for lazy and space evaluation
   constexpr Value LazyThreshold  = Value(1500);
+
+  // Most the terms left after each stage of the evaluation are assumed to be
+  // worth, when checking whether the score can still get back into the window
+  constexpr Value LazyMargin[] = { Value(1000), Value(700) };
   constexpr Value SpaceThreshold[VARIANT_NB] = {
     Value(12222),
 #ifdef ANTI
@@ -615,15 +619,19 @@ namespace {
 
 #undef S
 
-  // Evaluation class computes and stores attacks tables and other working data
-  template<Tracing T>
+  // Evaluation class computes and stores attacks tables and other working data.
+  // It is specialized for a variant V known at compile time, so that the terms
+  // of all the other variants fold away, or for any variant if V is VARIANT_NB.
+  template<Tracing T, Variant V = VARIANT_NB>
   class Evaluation {
 
   public:
     Evaluation() = delete;
-    explicit Evaluation(const Position& p) : pos(p) {}
+    explicit Evaluation(const Position& p, Value a = -VALUE_INFINITE, Value b = VALUE_INFINITE)
+      : pos(p), alpha(a), beta(b) {}
     Evaluation& operator=(const Evaluation&) = delete;
     Value value();
+    bool cut_by_window() const { return windowCut; }
 
   private:
     template<Color Us> void initialize();
@@ -636,7 +644,13 @@ namespace {
     ScaleFactor scale_factor(Value eg) const;
     Score initiative(Value eg) const;
 
+    Variant var() const { return V == VARIANT_NB ? pos.variant() : V; }
+    bool is(Variant v) const { return var() == v; }
+    bool outside_window(Value v, Value margin) const;
+
     const Position& pos;
+    Value alpha, beta;
+    bool windowCut = false;
     Material::Entry* me;
     Pawns::Entry* pe;
     Bitboard mobilityArea[COLOR_NB];
@@ -679,8 +693,8 @@ namespace {
 
   // Evaluation::initialize() computes king and pawn attacks, and the king ring
   // bitboard for a given color. This is done at the beginning of the evaluation.
-  template<Tracing T> template<Color Us>
-  void Evaluation<T>::initialize() {
+  template<Tracing T, Variant V> template<Color Us>
+  void Evaluation<T, V>::initialize() {
 
     constexpr Color     Them = (Us == WHITE ? BLACK : WHITE);
     constexpr Direction Up   = (Us == WHITE ? NORTH : SOUTH);
@@ -693,12 +707,12 @@ namespace {
     // Squares occupied by those pawns, by our king or queen, or controlled by enemy pawns
     // are excluded from the mobility area.
 #ifdef ANTI
-    if (pos.is_anti())
+    if (is(ANTI_VARIANT))
         mobilityArea[Us] = ~0;
     else
 #endif
 #ifdef HORDE
-    if (pos.is_horde() && pos.is_horde_color(Us))
+    if (is(HORDE_VARIANT) && pos.is_horde_color(Us))
         mobilityArea[Us] = ~(b | pe->pawn_attacks(Them));
     else
 #endif
@@ -706,7 +720,7 @@ namespace {
 
     // Initialise attackedBy bitboards for kings and pawns
 #ifdef ANTI
-    if (pos.is_anti())
+    if (is(ANTI_VARIANT))
     {
         attackedBy[Us][KING] = 0;
         Bitboard kings = pos.pieces(Us, KING);
@@ -716,7 +730,7 @@ namespace {
     else
 #endif
 #ifdef EXTINCTION
-    if (pos.is_extinction())
+    if (is(EXTINCTION_VARIANT))
     {
         attackedBy[Us][KING] = 0;
         Bitboard kings = pos.pieces(Us, KING);
@@ -726,12 +740,12 @@ namespace {
     else
 #endif
 #ifdef HORDE
-    if (pos.is_horde() && pos.is_horde_color(Us))
+    if (is(HORDE_VARIANT) && pos.is_horde_color(Us))
         attackedBy[Us][KING] = 0;
     else
 #endif
 #ifdef PLACEMENT
-    if (pos.is_placement() && pos.count_in_hand<KING>(Us))
+    if (is(CRAZYHOUSE_VARIANT) && pos.is_placement() && pos.count_in_hand<KING>(Us))
         attackedBy[Us][KING] = 0;
     else
 #endif
@@ -745,13 +759,13 @@ namespace {
     // Init our king safety tables only if we are going to use them
     if ((
 #ifdef ANTI
-        !pos.is_anti() &&
+        !is(ANTI_VARIANT) &&
 #endif
 #ifdef EXTINCTION
-        !pos.is_extinction() &&
+        !is(EXTINCTION_VARIANT) &&
 #endif
 #ifdef HORDE
-        !(pos.is_horde() && pos.is_horde_color(Us)) &&
+        !(is(HORDE_VARIANT) && pos.is_horde_color(Us)) &&
 #endif
         (pos.non_pawn_material(Them) >= RookValueMg + KnightValueMg))
     )
@@ -773,8 +787,8 @@ namespace {
 
 
   // Evaluation::pieces() scores pieces of a given color and type
-  template<Tracing T> template<Color Us, PieceType Pt>
-  Score Evaluation<T>::pieces() {
+  template<Tracing T, Variant V> template<Color Us, PieceType Pt>
+  Score Evaluation<T, V>::pieces() {
 
     constexpr Color     Them = (Us == WHITE ? BLACK : WHITE);
     constexpr Direction Down = (Us == WHITE ? SOUTH : NORTH);
@@ -796,7 +810,7 @@ namespace {
                          : pos.attacks_from<Pt>(s);
 
 #ifdef GRID
-        if (pos.is_grid())
+        if (is(GRID_VARIANT))
             b &= ~pos.grid_bb(s);
 #endif
         if (pos.blockers_for_king(Us) & s)
@@ -809,23 +823,23 @@ namespace {
         if (b & kingRing[Them] & ~double_pawn_attacks_bb<Them>(pos.pieces(Them, PAWN)))
         {
             kingAttackersCount[Us]++;
-            kingAttackersWeight[Us] += KingAttackWeights[pos.variant()][Pt];
+            kingAttackersWeight[Us] += KingAttackWeights[var()][Pt];
             kingAttacksCount[Us] += popcount(b & attackedBy[Them][KING]);
         }
 
         int mob = popcount(b & mobilityArea[Us]);
 
-        mobility[Us] += MobilityBonus[pos.variant()][Pt - 2][mob];
+        mobility[Us] += MobilityBonus[var()][Pt - 2][mob];
 #ifdef ANTI
-        if (pos.is_anti())
+        if (is(ANTI_VARIANT))
             continue;
 #endif
 #ifdef HORDE
-        if (pos.is_horde() && pos.is_horde_color(Us))
+        if (is(HORDE_VARIANT) && pos.is_horde_color(Us))
             continue;
 #endif
 #ifdef PLACEMENT
-        if (pos.is_placement() && pos.count_in_hand<KING>(Us))
+        if (is(CRAZYHOUSE_VARIANT) && pos.is_placement() && pos.count_in_hand<KING>(Us))
             continue;
 #endif
 
@@ -910,27 +924,27 @@ namespace {
 
 
   // Evaluation::king() assigns bonuses and penalties to a king of a given color
-  template<Tracing T> template<Color Us>
-  Score Evaluation<T>::king() const {
+  template<Tracing T, Variant V> template<Color Us>
+  Score Evaluation<T, V>::king() const {
 
 #ifdef ANTI
-    if (pos.is_anti())
+    if (is(ANTI_VARIANT))
         return SCORE_ZERO;
 #endif
 #ifdef EXTINCTION
-    if (pos.is_extinction())
+    if (is(EXTINCTION_VARIANT))
         return SCORE_ZERO;
 #endif
 #ifdef HORDE
-    if (pos.is_horde() && pos.is_horde_color(Us))
+    if (is(HORDE_VARIANT) && pos.is_horde_color(Us))
         return SCORE_ZERO;
 #endif
 #ifdef PLACEMENT
-    if (pos.is_placement() && pos.count_in_hand<KING>(Us))
+    if (is(CRAZYHOUSE_VARIANT) && pos.is_placement() && pos.count_in_hand<KING>(Us))
         return SCORE_ZERO;
 #endif
 #ifdef RACE
-    if (pos.is_race())
+    if (is(RACE_VARIANT))
         return SCORE_ZERO;
 #endif
 
@@ -960,7 +974,7 @@ namespace {
 
         // Attacked squares defended at most once by our queen or king
 #ifdef ATOMIC
-        if (pos.is_atomic())
+        if (is(ATOMIC_VARIANT))
             weak =  (attackedBy[Them][ALL_PIECES] | (pos.pieces(Them) ^ pos.pieces(Them, KING)))
                   & (~attackedBy[Us][ALL_PIECES] | attackedBy[Us][KING] | (attackedBy[Us][QUEEN] & ~attackedBy2[Us]));
         else
@@ -971,7 +985,7 @@ namespace {
 
         Bitboard h = 0;
 #ifdef CRAZYHOUSE
-        if (pos.is_house())
+        if (is(CRAZYHOUSE_VARIANT))
             h = pos.count_in_hand<QUEEN>(Them) ? weak & ~pos.pieces() : 0;
 #endif
 
@@ -979,7 +993,7 @@ namespace {
         safe  = ~pos.pieces(Them);
         safe &= ~attackedBy[Us][ALL_PIECES] | (weak & attackedBy2[Them]);
 #ifdef ATOMIC
-        if (pos.is_atomic())
+        if (is(ATOMIC_VARIANT))
             safe |= attackedBy[Us][KING];
 #endif
 
@@ -995,13 +1009,13 @@ namespace {
             kingDanger += QueenSafeCheck;
 
 #ifdef THREECHECK
-        if (pos.is_three_check() && pos.checks_given(Them))
+        if (is(THREECHECK_VARIANT) && pos.checks_given(Them))
             safe = ~pos.pieces(Them);
 #endif
 
         // Enemy rooks checks
 #ifdef CRAZYHOUSE
-        h = pos.is_house() && pos.count_in_hand<ROOK>(Them) ? ~pos.pieces() : 0;
+        h = is(CRAZYHOUSE_VARIANT) && pos.count_in_hand<ROOK>(Them) ? ~pos.pieces() : 0;
 #endif
         if (b1 & ((attackedBy[Them][ROOK] & safe) | (h & dropSafe)))
             kingDanger += RookSafeCheck;
@@ -1010,7 +1024,7 @@ namespace {
 
         // Enemy bishops checks
 #ifdef CRAZYHOUSE
-        h = pos.is_house() && pos.count_in_hand<BISHOP>(Them) ? ~pos.pieces() : 0;
+        h = is(CRAZYHOUSE_VARIANT) && pos.count_in_hand<BISHOP>(Them) ? ~pos.pieces() : 0;
 #endif
         if (b2 & ((attackedBy[Them][BISHOP] & safe) | (h & dropSafe)))
             kingDanger += BishopSafeCheck;
@@ -1020,7 +1034,7 @@ namespace {
         // Enemy knights checks
         b = pos.attacks_from<KNIGHT>(ksq);
 #ifdef CRAZYHOUSE
-        h = pos.is_house() && pos.count_in_hand<KNIGHT>(Them) ? ~pos.pieces() : 0;
+        h = is(CRAZYHOUSE_VARIANT) && pos.count_in_hand<KNIGHT>(Them) ? ~pos.pieces() : 0;
 #endif
         if (b & ((attackedBy[Them][KNIGHT] & safe) | (h & dropSafe)))
             kingDanger += KnightSafeCheck;
@@ -1029,7 +1043,7 @@ namespace {
 
 #ifdef CRAZYHOUSE
         // Enemy pawn checks
-        if (pos.is_house())
+        if (is(CRAZYHOUSE_VARIANT))
         {
             constexpr Direction Down = (Us == WHITE ? SOUTH : NORTH);
             b = pos.attacks_from<PAWN>(ksq, Us);
@@ -1046,7 +1060,7 @@ namespace {
         // the square is in the attacker's mobility area.
         unsafeChecks &= mobilityArea[Them];
 
-        const auto KDP = KingDangerParams[pos.variant()];
+        const auto KDP = KingDangerParams[var()];
         kingDanger +=        kingAttackersCount[Them] * kingAttackersWeight[Them]
                      + KDP[0] * kingAttacksCount[Them]
                      + KDP[1] * popcount(kingRing[Us] & weak)
@@ -1057,7 +1071,7 @@ namespace {
                      +          mg_value(mobility[Them] - mobility[Us])
                      + KDP[6];
 #ifdef CRAZYHOUSE
-        if (pos.is_house())
+        if (is(CRAZYHOUSE_VARIANT))
         {
             kingDanger += KingDangerInHand[ALL_PIECES] * pos.count_in_hand<ALL_PIECES>(Them);
             kingDanger += KingDangerInHand[PAWN] * pos.count_in_hand<PAWN>(Them);
@@ -1070,7 +1084,7 @@ namespace {
 #endif
 
 #ifdef ATOMIC
-        if (pos.is_atomic())
+        if (is(ATOMIC_VARIANT))
         {
             kingDanger += IndirectKingAttack * popcount(pos.attacks_from<KING>(pos.square<KING>(Us)) & pos.pieces(Us) & attackedBy[Them][ALL_PIECES]);
             score -= make_score(100, 100) * popcount(attackedBy[Us][KING] & pos.pieces());
@@ -1080,22 +1094,22 @@ namespace {
         if (kingDanger > 0)
         {
 #ifdef THREECHECK
-            if (pos.is_three_check())
+            if (is(THREECHECK_VARIANT))
                 kingDanger = ThreeCheckKSFactors[pos.checks_given(Them)] * kingDanger / 256;
 #endif
             int v = kingDanger * kingDanger / 4096;
 #ifdef ATOMIC
-            if (pos.is_atomic() && v > QueenValueMg)
+            if (is(ATOMIC_VARIANT) && v > QueenValueMg)
                 v = QueenValueMg;
 #endif
 #ifdef CRAZYHOUSE
-            if (pos.is_house() && Us == pos.side_to_move())
+            if (is(CRAZYHOUSE_VARIANT) && Us == pos.side_to_move())
                 v -= v / 10;
-            if (pos.is_house() && v > QueenValueMg)
+            if (is(CRAZYHOUSE_VARIANT) && v > QueenValueMg)
                 v = QueenValueMg;
 #endif
 #ifdef THREECHECK
-            if (pos.is_three_check() && v > QueenValueMg)
+            if (is(THREECHECK_VARIANT) && v > QueenValueMg)
                 v = QueenValueMg;
 #endif
             score -= make_score(v, kingDanger / 16 + KDP[7] * v / 256);
@@ -1107,7 +1121,7 @@ namespace {
         score -= PawnlessFlank;
 
     // King tropism bonus, to anticipate slow motion attacks on our king
-    score -= CloseEnemies[pos.variant()] * tropism;
+    score -= CloseEnemies[var()] * tropism;
 
     if (T)
         Trace::add(KING, Us, score);
@@ -1118,8 +1132,8 @@ namespace {
 
   // Evaluation::threats() assigns bonuses according to the types of the
   // attacking and the attacked pieces.
-  template<Tracing T> template<Color Us>
-  Score Evaluation<T>::threats() const {
+  template<Tracing T, Variant V> template<Color Us>
+  Score Evaluation<T, V>::threats() const {
 
     constexpr Color     Them     = (Us == WHITE ? BLACK   : WHITE);
     constexpr Direction Up       = (Us == WHITE ? NORTH   : SOUTH);
@@ -1128,7 +1142,7 @@ namespace {
     Bitboard b, weak, defended, nonPawnEnemies, stronglyProtected, safe, restricted;
     Score score = SCORE_ZERO;
 #ifdef ANTI
-    if (pos.is_anti())
+    if (is(ANTI_VARIANT))
     {
         constexpr Bitboard TRank2BB = (Us == WHITE ? Rank2BB : Rank7BB);
         bool weCapture = attackedBy[Us][ALL_PIECES] & pos.pieces(Them);
@@ -1169,7 +1183,7 @@ namespace {
     else
 #endif
 #ifdef ATOMIC
-    if (pos.is_atomic())
+    if (is(ATOMIC_VARIANT))
     {
         Bitboard attacks = pos.pieces(Them) & attackedBy[Us][ALL_PIECES] & ~attackedBy[Us][KING];
         while (attacks)
@@ -1189,10 +1203,10 @@ namespace {
     else
 #endif
 #ifdef GRID
-    if (pos.is_grid()) {} else
+    if (is(GRID_VARIANT)) {} else
 #endif
 #ifdef LOSERS
-    if (pos.is_losers())
+    if (is(LOSERS_VARIANT))
     {
         constexpr Bitboard TRank2BB = (Us == WHITE ? Rank2BB : Rank7BB);
         bool weCapture = attackedBy[Us][ALL_PIECES] & pos.pieces(Them);
@@ -1307,7 +1321,7 @@ namespace {
 
     // Bonus for threats on the next moves against enemy queen
 #ifdef CRAZYHOUSE
-    if ((pos.is_house() ? pos.count<QUEEN>(Them) - pos.count_in_hand<QUEEN>(Them) : pos.count<QUEEN>(Them)) == 1)
+    if ((is(CRAZYHOUSE_VARIANT) ? pos.count<QUEEN>(Them) - pos.count_in_hand<QUEEN>(Them) : pos.count<QUEEN>(Them)) == 1)
 #else
     if (pos.count<QUEEN>(Them) == 1)
 #endif
@@ -1335,8 +1349,8 @@ namespace {
   // Evaluation::passed() evaluates the passed pawns and candidate passed
   // pawns of the given color.
 
-  template<Tracing T> template<Color Us>
-  Score Evaluation<T>::passed() const {
+  template<Tracing T, Variant V> template<Color Us>
+  Score Evaluation<T, V>::passed() const {
 
     constexpr Color     Them = (Us == WHITE ? BLACK : WHITE);
     constexpr Direction Up   = (Us == WHITE ? NORTH : SOUTH);
@@ -1358,17 +1372,17 @@ namespace {
 
         int r = relative_rank(Us, s);
 
-        Score bonus = PassedRank[pos.variant()][r];
+        Score bonus = PassedRank[var()][r];
 
 #ifdef GRID
-        if (pos.is_grid()) {} else
+        if (is(GRID_VARIANT)) {} else
 #endif
         if (r > RANK_3)
         {
             int w = (r-2) * (r-2) + 2;
             Square blockSq = s + Up;
 #ifdef HORDE
-            if (pos.is_horde())
+            if (is(HORDE_VARIANT))
             {
                 // Assume a horde king distance of approximately 5
                 if (pos.is_horde_color(Us))
@@ -1379,15 +1393,15 @@ namespace {
             else
 #endif
 #ifdef PLACEMENT
-            if (pos.is_placement() && pos.count_in_hand<KING>(Us))
+            if (is(CRAZYHOUSE_VARIANT) && pos.is_placement() && pos.count_in_hand<KING>(Us))
                 bonus += make_score(0, 15 * w);
             else
 #endif
 #ifdef ANTI
-            if (pos.is_anti()) {} else
+            if (is(ANTI_VARIANT)) {} else
 #endif
 #ifdef ATOMIC
-            if (pos.is_atomic())
+            if (is(ATOMIC_VARIANT))
                 bonus += make_score(0, king_proximity(Them, blockSq) * 5 * w);
             else
 #endif
@@ -1455,10 +1469,10 @@ namespace {
   // twice. Finally, the space bonus is multiplied by a weight. The aim is to
   // improve play on game opening.
 
-  template<Tracing T> template<Color Us>
-  Score Evaluation<T>::space() const {
+  template<Tracing T, Variant V> template<Color Us>
+  Score Evaluation<T, V>::space() const {
 
-    if (pos.non_pawn_material() < SpaceThreshold[pos.variant()])
+    if (pos.non_pawn_material() < SpaceThreshold[var()])
         return SCORE_ZERO;
 
     constexpr Color Them = (Us == WHITE ? BLACK : WHITE);
@@ -1481,7 +1495,7 @@ namespace {
 
     Score score = make_score(bonus * weight * weight / 16, 0);
 #ifdef KOTH
-    if (pos.is_koth())
+    if (is(KOTH_VARIANT))
         score += KothSafeCenter * popcount(behind & safe & Center);
 #endif
 
@@ -1493,15 +1507,15 @@ namespace {
 
   // Evaluation::variant() computes variant-specific evaluation terms.
 
-  template<Tracing T> template<Color Us>
-  Score Evaluation<T>::variant() const {
+  template<Tracing T, Variant V> template<Color Us>
+  Score Evaluation<T, V>::variant() const {
 
     constexpr Color Them = (Us == WHITE ? BLACK : WHITE);
 
     Score score = SCORE_ZERO;
 
 #ifdef HORDE
-    if (pos.is_horde() && pos.is_horde_color(Them))
+    if (is(HORDE_VARIANT) && pos.is_horde_color(Them))
     {
         // Add a bonus according to how close we are to breaking through the pawn wall
         if (pos.pieces(Us, ROOK) | pos.pieces(Us, QUEEN))
@@ -1524,7 +1538,7 @@ namespace {
     }
 #endif
 #ifdef KOTH
-    if (pos.is_koth())
+    if (is(KOTH_VARIANT))
     {
         constexpr Direction Up = (Us == WHITE ? NORTH : SOUTH);
         Bitboard pinned = pos.blockers_for_king(Them) & pos.pieces(Them);
@@ -1542,7 +1556,7 @@ namespace {
     }
 #endif
 #ifdef RACE
-    if (pos.is_race())
+    if (is(RACE_VARIANT))
     {
         Square ksq = pos.square<KING>(Us);
         int s = relative_rank(BLACK, ksq);
@@ -1553,7 +1567,7 @@ namespace {
     }
 #endif
 #ifdef THREECHECK
-    if (pos.is_three_check())
+    if (is(THREECHECK_VARIANT))
         score += ChecksGivenBonus[pos.checks_given(Us)];
 #endif
 
@@ -1568,19 +1582,19 @@ namespace {
   // for the position. It is a second order bonus/malus based on the
   // known attacking/defending status of the players.
 
-  template<Tracing T>
-  Score Evaluation<T>::initiative(Value eg) const {
+  template<Tracing T, Variant V>
+  Score Evaluation<T, V>::initiative(Value eg) const {
 
 #ifdef ANTI
-    if (pos.is_anti())
+    if (is(ANTI_VARIANT))
         return SCORE_ZERO;
 #endif
 #ifdef HORDE
-    if (pos.is_horde())
+    if (is(HORDE_VARIANT))
         return SCORE_ZERO;
 #endif
 #ifdef PLACEMENT
-    if (pos.is_placement() && (pos.count_in_hand<KING>(WHITE) || pos.count_in_hand<KING>(BLACK)))
+    if (is(CRAZYHOUSE_VARIANT) && pos.is_placement() && (pos.count_in_hand<KING>(WHITE) || pos.count_in_hand<KING>(BLACK)))
         return SCORE_ZERO;
 #endif
 
@@ -1612,17 +1626,17 @@ namespace {
 
   // Evaluation::scale_factor() computes the scale factor for the winning side
 
-  template<Tracing T>
-  ScaleFactor Evaluation<T>::scale_factor(Value eg) const {
+  template<Tracing T, Variant V>
+  ScaleFactor Evaluation<T, V>::scale_factor(Value eg) const {
 
     Color strongSide = eg > VALUE_DRAW ? WHITE : BLACK;
     int sf = me->scale_factor(pos, strongSide);
 
 #ifdef ATOMIC
-    if (pos.is_atomic()) {} else
+    if (is(ATOMIC_VARIANT)) {} else
 #endif
 #ifdef HORDE
-    if (pos.is_horde() && pos.is_horde_color(~strongSide))
+    if (is(HORDE_VARIANT) && pos.is_horde_color(~strongSide))
     {
         if (pos.non_pawn_material(~strongSide) >= QueenValueMg)
             sf = ScaleFactor(10);
@@ -1630,7 +1644,7 @@ namespace {
     else
 #endif
 #ifdef GRID
-    if (pos.is_grid() && pos.non_pawn_material(strongSide) <= RookValueMg)
+    if (is(GRID_VARIANT) && pos.non_pawn_material(strongSide) <= RookValueMg)
         sf = 10;
     else
 #endif
@@ -1650,16 +1664,36 @@ namespace {
   }
 
 
+  // Evaluation::outside_window() tells whether the score 'v', from the point of
+  // view of white, is so far outside the search window that terms worth at most
+  // 'margin' cannot bring it back. The search does not need an exact value then.
+  // Only in builds made with "lazyeval=yes", as it changes the search.
+
+  template<Tracing T, Variant V>
+  bool Evaluation<T, V>::outside_window(Value v, Value margin) const {
+
+#ifdef LAZY_EVAL
+    if (pos.side_to_move() == BLACK)
+        v = -v;
+
+    return v - margin >= beta || v + margin <= alpha;
+#else
+    (void)v, (void)margin;
+    return false;
+#endif
+  }
+
+
   // Evaluation::value() is the main function of the class. It computes the various
   // parts of the evaluation and returns the value of the position from the point
   // of view of the side to move.
 
-  template<Tracing T>
-  Value Evaluation<T>::value() {
+  template<Tracing T, Variant V>
+  Value Evaluation<T, V>::value() {
 
     assert(!pos.checkers());
 
-    if (pos.is_variant_end())
+    if (var() != CHESS_VARIANT && pos.is_variant_end())
         return pos.variant_result();
 
     // Probe the material hash table
@@ -1679,11 +1713,11 @@ namespace {
     pe = Pawns::probe(pos);
     score += pe->pawn_score(WHITE) - pe->pawn_score(BLACK);
 
-    // Early exit if score is high
+    // Early exit if score is high, or too far outside the search window
     Value v = (mg_value(score) + eg_value(score)) / 2;
-    if (pos.variant() == CHESS_VARIANT)
+    if (var() == CHESS_VARIANT)
     {
-    if (abs(v) > LazyThreshold)
+    if (abs(v) > LazyThreshold || (windowCut = outside_window(v, LazyMargin[0])))
        return pos.side_to_move() == WHITE ? v : -v;
     }
 
@@ -1699,7 +1733,7 @@ namespace {
             + pieces<WHITE, QUEEN >() - pieces<BLACK, QUEEN >();
 
 #ifdef CRAZYHOUSE
-    if (pos.is_house()) {
+    if (is(CRAZYHOUSE_VARIANT)) {
         // Positional bonus for potential drop points - unoccupied squares in enemy territory that are not attacked by enemy non-KQ pieces
         mobility[WHITE] += DropMobilityBonus * popcount(~(attackedBy[BLACK][PAWN] | attackedBy[BLACK][KNIGHT] | attackedBy[BLACK][BISHOP] | attackedBy[BLACK][ROOK] | pos.pieces() | Rank1234BB));
         mobility[BLACK] += DropMobilityBonus * popcount(~(attackedBy[WHITE][PAWN] | attackedBy[WHITE][KNIGHT] | attackedBy[WHITE][BISHOP] | attackedBy[WHITE][ROOK] | pos.pieces() | Rank5678BB));
@@ -1708,12 +1742,20 @@ namespace {
 
     score += mobility[WHITE] - mobility[BLACK];
 
+    // Second chance to exit early, before the king safety and threats
+    if (var() == CHESS_VARIANT)
+    {
+        v = (mg_value(score) + eg_value(score)) / 2;
+        if ((windowCut = outside_window(v, LazyMargin[1])))
+            return pos.side_to_move() == WHITE ? v : -v;
+    }
+
     score +=  king<   WHITE>() - king<   BLACK>()
             + threats<WHITE>() - threats<BLACK>()
             + passed< WHITE>() - passed< BLACK>()
             + space<  WHITE>() - space<  BLACK>();
 
-    if (pos.variant() != CHESS_VARIANT)
+    if (var() != CHESS_VARIANT)
         score += variant<WHITE>() - variant<BLACK>();
 
     score += initiative(eg_value(score));
@@ -1736,7 +1778,30 @@ namespace {
     }
 
     return  (pos.side_to_move() == WHITE ? v : -v) // Side to move point of view
-           + Eval::Tempo[pos.variant()];
+           + Eval::Tempo[var()];
+  }
+
+
+  // cached_value() evaluates the position and keeps the result in the cache
+  // entry, unless the search window cut the evaluation short.
+
+  template<Variant V>
+  Value cached_value(const Position& pos, Value alpha, Value beta, Eval::CacheEntry* e, bool* windowCut) {
+
+    Evaluation<NO_TRACE, V> ev(pos, alpha, beta);
+    Value v = ev.value();
+
+    if (windowCut)
+        *windowCut = ev.cut_by_window();
+
+    if (e && !ev.cut_by_window())
+    {
+        e->key = pos.key();
+        e->value = v;
+        e->contempt = pos.this_thread()->contempt;
+    }
+
+    return v;
   }
 
 } // namespace
@@ -1744,9 +1809,27 @@ namespace {
 
 /// evaluate() is the evaluator for the outer world. It returns a static
 /// evaluation of the position from the point of view of the side to move.
+/// If windowCut is given, it tells whether the value is only good enough to
+/// compare with the window, as the evaluation was cut short.
+
+Value Eval::evaluate(const Position& pos, Value alpha, Value beta, bool* windowCut) {
+
+  CacheEntry* e = nullptr;
+
+#if EVAL_CACHE_SIZE
+  Thread* thisThread = pos.this_thread();
+  e = thisThread->evalCache[pos.key()];
+  thisThread->evalProbes++;
+
+  if (e->key == pos.key() && e->contempt == thisThread->contempt)
+  {
+      thisThread->evalHits++;
+      return e->value;
+  }
+#endif
 
-Value Eval::evaluate(const Position& pos) {
-  return Evaluation<NO_TRACE>(pos).value();
+  return pos.variant() == CHESS_VARIANT ? cached_value<CHESS_VARIANT>(pos, alpha, beta, e, windowCut)
+                                        : cached_value<VARIANT_NB>(pos, alpha, beta, e, windowCut);
 }
 
 
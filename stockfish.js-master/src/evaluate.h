@@ -23,12 +23,31 @@
 
 #include <string>
 
+#include "misc.h"
 #include "types.h"
 
 class Position;
 
+/// EVAL_CACHE_SIZE is the number of entries, a power of two, in the evaluation
+/// cache of each thread. It is set with "make build evalcache=N", and is 0 (no
+/// cache) by default, as the TT already keeps the static eval of most nodes.
+#ifndef EVAL_CACHE_SIZE
+#define EVAL_CACHE_SIZE 0
+#endif
+
 namespace Eval {
 
+/// The evaluation cache keeps the static evals of recently evaluated positions,
+/// which the TT only stores together with a search result. The evaluation also
+/// depends on the contempt, so that is part of the entry.
+struct CacheEntry {
+  Key key;
+  Value value;
+  Score contempt;
+};
+
+typedef HashTable<CacheEntry, EVAL_CACHE_SIZE> Cache;
+
 constexpr Value Tempo[VARIANT_NB] = { // Must be visible to search
   Value(20),
 #ifdef ANTI
@@ -68,7 +87,8 @@ constexpr Value Tempo[VARIANT_NB] = { // Must be visible to search
 
 std::string trace(const Position& pos);
 
-Value evaluate(const Position& pos);
+Value evaluate(const Position& pos, Value alpha = -VALUE_INFINITE, Value beta = VALUE_INFINITE,
+               bool* windowCut = nullptr);
 }
 
 #endif // #ifndef EVALUATE_H_INCLUDED
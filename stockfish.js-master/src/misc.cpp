@@ -41,6 +41,15 @@ typedef bool(*fun3_t)(HANDLE, CONST GROUP_AFFINITY*, PGROUP_AFFINITY);
 }
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__) && !defined(__EMSCRIPTEN__)
+#define USE_HUGE_PAGES
+#define USE_NUMA_BINDING
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -231,11 +240,251 @@ void prefetch2(void* addr) {
   prefetch((uint8_t*)addr + 64);
 }
 
+#ifdef __EMSCRIPTEN__
+namespace InfoRing {
+
+namespace {
+
+  constexpr uint32_t Capacity = 1 << 16;
+
+  alignas(64) uint32_t ring[4 + Capacity / 4] = { Capacity };
+}
+
+/// header() returns the ring, whose data starts right after the 16 bytes of
+/// the header.
+
+uint32_t* header() { return ring; }
+
+
+/// write() appends a record, padded to 4 bytes, written by a single thread.
+/// If the host is too slow to read the ring, the record is dropped and false
+/// is returned, so that the search never waits for the host.
+
+bool write(const void* record, size_t size) {
+
+  assert(size % 4 == 0 && size < Capacity);
+
+  uint8_t* data = reinterpret_cast<uint8_t*>(ring + 4);
+  uint32_t written = ring[1], read = __atomic_load_n(&ring[2], __ATOMIC_ACQUIRE);
+  uint32_t pos = written % Capacity;
+  uint32_t pad = Capacity - pos < size ? Capacity - pos : 0;
+
+  if (written + pad + size - read > Capacity)
+  {
+      ring[3]++;
+      return false;
+  }
+
+  if (pad)
+  {
+      uint16_t padSize = uint16_t(pad);
+      std::memcpy(data + pos, &padSize, sizeof(padSize));
+      data[pos + 2] = PAD;
+  }
+
+  std::memcpy(data + (written + pad) % Capacity, record, size);
+  __atomic_store_n(&ring[1], written + pad + uint32_t(size), __ATOMIC_RELEASE);
+  return true;
+}
+
+} // namespace InfoRing
+
+extern "C" uint32_t* info_ring() { return InfoRing::header(); }
+#endif
+
+
+namespace LargePages {
+
+#ifdef USE_HUGE_PAGES
+
+namespace {
+
+  constexpr size_t HugePageSize = 2 * 1024 * 1024;
+  constexpr size_t GigaPageSize = 1024 * 1024 * 1024;
+
+  size_t round_up(size_t size, size_t page) { return (size + page - 1) / page * page; }
+
+  // Explicit huge pages must have been reserved by the administrator, e.g.
+  // through /proc/sys/vm/nr_hugepages, otherwise mmap() fails immediately.
+  void* map_hugetlb(size_t size, size_t page, int log2Page) {
+
+#ifdef MAP_HUGETLB
+#  ifndef MAP_HUGE_SHIFT
+#    define MAP_HUGE_SHIFT 26
+#  endif
+    void* mem = mmap(nullptr, round_up(size, page), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2Page << MAP_HUGE_SHIFT), -1, 0);
+    return mem == MAP_FAILED ? nullptr : mem;
+#else
+    (void)size, (void)page, (void)log2Page;
+    return nullptr;
+#endif
+  }
+
+  // Transparent huge pages are only worth asking for when the kernel has not
+  // been configured to never use them.
+  bool thp_available() {
+
+    std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    return std::getline(f, mode) && mode.find("[never]") == std::string::npos;
+  }
+
+} // namespace
+
+#endif
+
+/// alloc() returns a block of at least 'size' bytes aligned to a cache line,
+/// or nullptr if even the plain allocation fails.
+
+void* alloc(size_t size, bool allowLarge, Backing& backing) {
+
+  void* mem = nullptr;
+
+#ifdef USE_HUGE_PAGES
+  if (allowLarge)
+  {
+      if (size >= GigaPageSize && (mem = map_hugetlb(size, GigaPageSize, 30)))
+          return backing = HUGETLB_1GB, mem;
+
+      if ((mem = map_hugetlb(size, HugePageSize, 21)))
+          return backing = HUGETLB_2MB, mem;
+
+      if (   size >= HugePageSize
+          && thp_available()
+          && !posix_memalign(&mem, HugePageSize, round_up(size, HugePageSize)))
+      {
+          madvise(mem, round_up(size, HugePageSize), MADV_HUGEPAGE);
+          return backing = TRANSPARENT, mem;
+      }
+  }
+#else
+  (void)allowLarge;
+#endif
+
+  mem = malloc(size);
+  backing = mem ? MALLOC : NONE;
+  return mem;
+}
+
+
+/// free() releases a block obtained from alloc()
+
+void free(void* mem, size_t size, Backing backing) {
+
+#ifdef USE_HUGE_PAGES
+  if (backing == HUGETLB_1GB || backing == HUGETLB_2MB)
+  {
+      munmap(mem, round_up(size, backing == HUGETLB_1GB ? GigaPageSize : HugePageSize));
+      return;
+  }
+#else
+  (void)size;
+#endif
+
+  if (backing != NONE)
+      std::free(mem);
+}
+
+
+const char* name(Backing backing) {
+
+  return backing == HUGETLB_1GB ? "1GB huge pages"
+       : backing == HUGETLB_2MB ? "2MB huge pages"
+       : backing == TRANSPARENT ? "transparent huge pages"
+       : backing == MALLOC      ? "normal pages" : "none";
+}
+
+} // namespace LargePages
+
 namespace WinProcGroup {
 
-#ifndef _WIN32
+#if defined(USE_NUMA_BINDING)
+
+/// cpu_list() parses a list of processors in the format of the files under
+/// /sys/devices/system, like "0-15,32-47".
+
+vector<int> cpu_list(const string& fname) {
+
+  vector<int> cpus;
+  ifstream file(fname);
+  string range;
+
+  while (getline(file, range, ','))
+  {
+      int first, last;
+      char dash;
+      istringstream ss(range);
+
+      if (!(ss >> first))
+          continue;
+
+      if (!(ss >> dash >> last))
+          last = first;
+
+      for (int c = first; c <= last; ++c)
+          cpus.push_back(c);
+  }
+
+  return cpus;
+}
+
+
+/// best_node() reads the NUMA topology from /sys and returns the node for the
+/// thread with index idx, filling the nodes one after the other with as many
+/// threads as they have logical processors we may run on. The processors of
+/// that node are returned in 'mask'. Returns -1 if there is a single node, or
+/// more threads than processors, and the OS should decide.
+
+int best_node(size_t idx, cpu_set_t* mask) {
 
-void bindThisThread(size_t) {}
+  cpu_set_t allowed;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed))
+      return -1;
+
+  vector<int> nodes = cpu_list("/sys/devices/system/node/online");
+
+  if (nodes.size() < 2)
+      return -1;
+
+  for (int n : nodes)
+  {
+      CPU_ZERO(mask);
+
+      for (int c : cpu_list("/sys/devices/system/node/node" + to_string(n) + "/cpulist"))
+          if (c < CPU_SETSIZE && CPU_ISSET(c, &allowed))
+              CPU_SET(c, mask);
+
+      size_t cnt = CPU_COUNT(mask);
+
+      if (idx < cnt)
+          return n;
+
+      idx -= cnt;
+  }
+
+  return -1;
+}
+
+
+/// bindThisThread() pins the current thread to the processors of its node
+
+int bindThisThread(size_t idx) {
+
+  // Use only local variables to be thread-safe
+  cpu_set_t mask;
+  int node = best_node(idx, &mask);
+
+  if (node == -1 || sched_setaffinity(0, sizeof(mask), &mask))
+      return -1;
+
+  return node;
+}
+
+#elif !defined(_WIN32)
+
+int bindThisThread(size_t) { return -1; }
 
 #else
 
@@ -311,13 +560,13 @@ int best_group(size_t idx) {
 
 /// bindThisThread() set the group affinity of the current thread
 
-void bindThisThread(size_t idx) {
+int bindThisThread(size_t idx) {
 
   // Use only local variables to be thread-safe
   int group = best_group(idx);
 
   if (group == -1)
-      return;
+      return -1;
 
   // Early exit if the needed API are not available at runtime
   HMODULE k32 = GetModuleHandle("Kernel32.dll");
@@ -325,11 +574,13 @@ void bindThisThread(size_t idx) {
   auto fun3 = (fun3_t)(void(*)())GetProcAddress(k32, "SetThreadGroupAffinity");
 
   if (!fun2 || !fun3)
-      return;
+      return -1;
 
   GROUP_AFFINITY affinity;
-  if (fun2(group, &affinity))
-      fun3(GetCurrentThread(), &affinity, nullptr);
+  if (fun2(group, &affinity) && fun3(GetCurrentThread(), &affinity, nullptr))
+      return group;
+
+  return -1;
 }
 
 #endif
@@ -56,6 +56,7 @@ inline TimePoint now() {
 template<class Entry, int Size>
 struct HashTable {
   Entry* operator[](Key key) { return &table[(uint32_t)key & (Size - 1)]; }
+  size_t size_in_bytes() const { return table.size() * sizeof(Entry); }
 
 private:
   std::vector<Entry> table = std::vector<Entry>(Size);
@@ -106,14 +107,65 @@ public:
 };
 
 
+/// Big tables that are accessed at random, like the transposition table, take
+/// a TLB miss on nearly every access when they sit on ordinary 4KB pages. Where
+/// the platform supports it, LargePages::alloc() backs such a table by explicit
+/// 1GB or 2MB huge pages, then by transparent huge pages, and falls back to a
+/// plain allocation otherwise. The backing actually obtained is returned in
+/// 'backing' and must be passed back to LargePages::free() together with the
+/// same size.
+
+namespace LargePages {
+
+  enum Backing { NONE, MALLOC, TRANSPARENT, HUGETLB_2MB, HUGETLB_1GB };
+
+  void* alloc(size_t size, bool allowLarge, Backing& backing);
+  void free(void* mem, size_t size, Backing backing);
+  const char* name(Backing backing);
+}
+
+
+#ifdef __EMSCRIPTEN__
+/// In the JS builds the PV info can reach the host as binary records in a ring
+/// buffer on the heap instead of as text lines, which saves the formatting on
+/// our side and the string copies on the way out. post.js reads the ring. The
+/// header holds the capacity, then the bytes written and read so far, both
+/// modulo 2^32, then the number of records dropped because the ring was full.
+/// Records are padded to 4 bytes and never wrap: a PAD record skips the end.
+
+namespace InfoRing {
+
+  enum RecordType : uint8_t { PAD, PV };
+  enum Flags : uint8_t { LOWERBOUND = 1, UPPERBOUND = 2, MATE = 4, BMC = 8 };
+
+  struct PvRecord {
+    uint16_t size;
+    RecordType type;
+    uint8_t flags;
+    uint16_t depth, selDepth, multiPV, hashfull; // hashfull is 0xFFFF if not known yet
+    int32_t score;                               // In centipawns, or moves to mate
+    uint32_t time, nodesLo, nodesHi;
+    float bmc;
+    uint16_t pvLength;
+    uint16_t pv[MAX_PLY + 1];                    // See UCI::wire_move()
+  };
+
+  uint32_t* header();
+  bool write(const void* record, size_t size);
+}
+#endif
+
+
 /// Under Windows it is not possible for a process to run on more than one
 /// logical processor group. This usually means to be limited to use max 64
 /// cores. To overcome this, some special platform specific API should be
 /// called to set group affinity for each thread. Original code from Texel by
-/// Peter Österlund.
+/// Peter Österlund. Under Linux the thread is pinned to the processors of a
+/// NUMA node instead, so that the memory it touches first is local. Returns
+/// the group or node the thread was bound to, or -1 if it was left alone.
 
 namespace WinProcGroup {
-  void bindThisThread(size_t idx);
+  int bindThisThread(size_t idx);
 }
 
 #endif // #ifndef MISC_H_INCLUDED
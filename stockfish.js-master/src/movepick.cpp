@@ -21,6 +21,7 @@
 #include <cassert>
 
 #include "movepick.h"
+#include "thread.h"
 
 namespace {
 
@@ -69,6 +70,12 @@ MovePicker::MovePicker(const Position& p, Move ttm, Depth d, const ButterflyHist
   stage = pos.checkers() ? EVASION_TT : MAIN_TT;
   ttMove = ttm && pos.pseudo_legal(ttm) ? ttm : MOVE_NONE;
   stage += (ttMove == MOVE_NONE);
+
+#ifdef TT_STATS
+  // Track TT moves not valid in this position (key collisions or torn entries)
+  if (ttm)
+      pos.this_thread()->ttMoves++, pos.this_thread()->ttMoveRejects += !ttMove;
+#endif
 }
 
 /// MovePicker constructor for quiescence search
@@ -289,3 +296,27 @@ top:
   assert(false);
   return MOVE_NONE; // Silence warning
 }
+
+#ifdef PREFETCH_AHEAD
+/// MovePicker::prefetch_ahead() prefetches the hash entries for the positions
+/// after the next PREFETCH_AHEAD moves in the current stage, so that their
+/// memory latency overlaps with the search of the current move. The moves are
+/// taken in list order, which is about the order of next_move() once a stage
+/// is scored and sorted. Moves prefetched already are skipped.
+void MovePicker::prefetch_ahead() {
+
+  // Refutations are not validated yet, and the TT move is handed out alone
+  if (   stage != GOOD_CAPTURE && stage != QUIET && stage != BAD_CAPTURE
+      && stage != EVASION && stage != QCAPTURE && stage != QCHECK)
+      return;
+
+  ExtMove* last = std::min(cur + PREFETCH_AHEAD, endMoves);
+
+  if (prefetched < cur || prefetched > endMoves)
+      prefetched = cur;
+
+  for ( ; prefetched < last; ++prefetched)
+      if (*prefetched != ttMove)
+          pos.prefetch_after(*prefetched);
+}
+#endif
@@ -132,6 +132,9 @@ public:
                                            Move,
                                            Move*);
   Move next_move(bool skipQuiets = false);
+#ifdef PREFETCH_AHEAD
+  void prefetch_ahead();
+#endif
 
 private:
   template<PickType T, typename Pred> Move select(Pred);
@@ -145,6 +148,9 @@ private:
   const PieceToHistory** continuationHistory;
   Move ttMove;
   ExtMove refutations[3], *cur, *endMoves, *endBadCaptures;
+#ifdef PREFETCH_AHEAD
+  ExtMove* prefetched = nullptr;
+#endif
   int stage;
   Move move;
   Square recaptureSquare;
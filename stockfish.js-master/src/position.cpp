@@ -1505,15 +1505,17 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
 #ifdef ATOMIC
       if (is_atomic()) // Remove the blast piece(s)
       {
-          Bitboard blast = attacks_from<KING>(to) - from;
-          while (blast)
+          Bitboard blast = (attacks_from<KING>(to) & (pieces() ^ pieces(PAWN))) | from;
+          st->blastBB = blast;
+          st->blastPieces = 0;
+          for (int i = 0; blast; ++i)
           {
               Square bsq = pop_lsb(&blast);
               Piece bpc = piece_on(bsq);
-              st->blast[bsq] = bpc;
-              if (bpc != NO_PIECE && type_of(bpc) != PAWN)
+              st->blastPieces |= uint64_t(bpc) << (4 * i);
+              if (bsq != from) // The capturing piece is removed below
               {
-                  Color bc = color_of(st->blast[bsq]);
+                  Color bc = color_of(bpc);
                   st->nonPawnMaterial[bc] -= PieceValue[CHESS_VARIANT][MG][type_of(bpc)];
 
                   // Update board and piece lists
@@ -1595,7 +1597,6 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
 #ifdef ATOMIC
   if (is_atomic() && captured) // Remove the blast piece(s)
   {
-      st->blast[from] = piece_on(from);
       remove_piece(pc, from);
       // Update material (hash key already updated)
       st->materialKey ^= Zobrist::psq[pc][pieceCount[pc]];
@@ -1752,7 +1753,7 @@ void Position::undo_move(Move m) {
   Piece pc = piece_on(to);
 #ifdef ATOMIC
   if (is_atomic() && st->capturedPiece) // Restore the blast piece(s)
-      pc = st->blast[from];
+      pc = Piece((st->blastPieces >> (4 * popcount(st->blastBB & (SquareBB[from] - 1)))) & 15);
 #endif
 
   assert(empty(to) || color_of(piece_on(to)) == us);
@@ -1855,15 +1856,12 @@ void Position::undo_move(Move m) {
 #ifdef ATOMIC
           if (is_atomic() && st->capturedPiece) // Restore the blast piece(s)
           {
-              Bitboard blast = attacks_from<KING>(to); // squares in blast radius
-              while (blast)
+              Bitboard blast = st->blastBB;
+              for (uint64_t bpcs = st->blastPieces; blast; bpcs >>= 4)
               {
                   Square bsq = pop_lsb(&blast);
-                  if (bsq == from)
-                      continue;
-                  Piece bpc = st->blast[bsq];
-                  if (bpc != NO_PIECE && type_of(bpc) != PAWN)
-                      put_piece(bpc, bsq);
+                  if (bsq != from) // The capturing piece is restored above
+                      put_piece(Piece(bpcs & 15), bsq);
               }
           }
 #endif
@@ -2005,6 +2003,30 @@ Key Position::key_after(Move m) const {
   return k ^ Zobrist::psq[pc][to] ^ Zobrist::psq[pc][from];
 }
 
+#ifdef PREFETCH_AHEAD
+/// Position::prefetch_after() prefetches the TT cluster of the position after
+/// the given move, and for captures and pawn moves also its material and pawn
+/// hash entries, as do_move() would. Like key_after() it ignores special moves
+/// and variant rules, a wrong guess just wastes a prefetch.
+
+void Position::prefetch_after(Move m) const {
+
+  Square from = from_sq(m);
+  Square to = to_sq(m);
+  Piece pc = moved_piece(m);
+  Piece captured = piece_on(to);
+
+  prefetch(TT.first_entry(key_after(m)));
+
+  if (captured)
+      prefetch(thisThread->materialTable[st->materialKey ^ Zobrist::psq[captured][pieceCount[captured] - 1]]);
+
+  if (type_of(pc) == PAWN && from != to)
+      prefetch(thisThread->pawnsTable[  st->pawnKey ^ Zobrist::psq[pc][from] ^ Zobrist::psq[pc][to]
+                                      ^ (type_of(captured) == PAWN ? Zobrist::psq[captured][to] : 0)]);
+}
+#endif
+
 #ifdef ATOMIC
 template<>
 Value Position::see<ATOMIC_VARIANT>(Move m, PieceType nextVictim, Square s) const {
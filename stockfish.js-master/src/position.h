@@ -51,11 +51,12 @@ struct StateInfo {
   Key        key;
   Bitboard   checkersBB;
   Piece      capturedPiece;
-#ifdef ATOMIC
-  Piece      blast[SQUARE_NB];
-#endif
 #ifdef CRAZYHOUSE
   bool       capturedpromoted;
+#endif
+#ifdef ATOMIC
+  Bitboard   blastBB;     // Non-pawn pieces destroyed by a capture, and its from square
+  uint64_t   blastPieces; // The pieces on those squares, 4 bits each in square order
 #endif
   StateInfo* previous;
   Bitboard   blockersForKing[COLOR_NB];
@@ -166,6 +167,9 @@ public:
   // Accessing hash keys
   Key key() const;
   Key key_after(Move m) const;
+#ifdef PREFETCH_AHEAD
+  void prefetch_after(Move m) const;
+#endif
   Key material_key() const;
   Key pawn_key() const;
 
@@ -189,25 +189,160 @@ return Module;
 } /// End of load_stockfish() from pre.js
 
 
+function square(s)
+{
+    return "abcdefgh"[s & 7] + ((s >> 3) + 1);
+}
+
+/// Unpacks a move written by UCI::wire_move().
+function decode_move(m)
+{
+    var pieceType = (m >> 12) & 7;
+    
+    if (!m) {
+        return "0000";
+    }
+    if (m & 0x8000) {
+        return " PNBRQK"[pieceType] + "@" + square(m & 63);
+    }
+    return square((m >> 6) & 63) + square(m & 63) + (pieceType ? " pnbrqk"[pieceType] : "");
+}
+
+/// A PV info record of the info ring (see InfoRing in misc.h), decoded field by field when read.
+///NOTE: It points into the engine's heap, so it is only valid during the call to oninfo().
+///      Copy what you need to keep.
+function InfoRecord(view, offset)
+{
+    this.view = view;
+    this.offset = offset;
+}
+
+InfoRecord.prototype = {
+    get depth()    { return this.view.getUint16(this.offset + 4, true); },
+    get seldepth() { return this.view.getUint16(this.offset + 6, true); },
+    get multipv()  { return this.view.getUint16(this.offset + 8, true); },
+    get hashfull()
+    {
+        var hashfull = this.view.getUint16(this.offset + 10, true);
+        return hashfull === 0xFFFF ? undefined : hashfull;
+    },
+    get score()
+    {
+        return {
+            unit: this.view.getUint8(this.offset + 3) & 4 ? "mate" : "cp",
+            value: this.view.getInt32(this.offset + 12, true)
+        };
+    },
+    get bound()
+    {
+        var flags = this.view.getUint8(this.offset + 3);
+        return flags & 1 ? "lowerbound" : flags & 2 ? "upperbound" : undefined;
+    },
+    get time()     { return this.view.getUint32(this.offset + 16, true); },
+    get nodes()    { return this.view.getUint32(this.offset + 24, true) * 4294967296 + this.view.getUint32(this.offset + 20, true); },
+    get nps()      { return Math.floor(this.nodes * 1000 / this.time); },
+    get bmc()      { return this.view.getFloat32(this.offset + 28, true); },
+    get pv()
+    {
+        var len = this.view.getUint16(this.offset + 32, true),
+            pv = [],
+            i;
+        
+        for (i = 0; i < len; i += 1) {
+            pv.push(decode_move(this.view.getUint16(this.offset + 34 + i * 2, true)));
+        }
+        
+        return pv;
+    },
+    /// The line UCI::pv() would have printed
+    toString: function toString()
+    {
+        var score = this.score,
+            bound = this.bound,
+            hashfull = this.hashfull;
+        
+        return "info depth " + this.depth +
+               " seldepth " + this.seldepth +
+               " multipv " + this.multipv +
+               " score " + score.unit + " " + score.value +
+               (bound ? " " + bound : "") +
+               " nodes " + this.nodes +
+               " nps " + this.nps +
+               (typeof hashfull === "undefined" ? "" : " hashfull " + hashfull) +
+               " time " + this.time +
+               " pv " + this.pv.join(" ") +
+               (this.view.getUint8(this.offset + 3) & 8 ? " bmc " + Number(this.bmc.toPrecision(6)) : "");
+    }
+};
+
+
 /// This is returned to STOCKFISH() in pre.js.
 return function (WasmPath)
 {
     var myConsole,
         Module,
         workerObj,
+        ringPtr,
         cmds = [],
-        wait = typeof setImmediate === "function" ? setImmediate : setTimeout;
+        drainTimer = null,
+        wait = typeof setImmediate === "function" ? setImmediate : setTimeout,
+        infoTimer;
+    
+    function emit(line)
+    {
+        if (workerObj.onmessage) {
+            /// Match Web Workers.
+            workerObj.onmessage(line)
+        } else {
+            console.error("You must set onmessage");
+            console.info(line);
+        }
+    }
+    
+    /// Hands the records of the info ring to oninfo(), or prints them if it is not set.
+    function read_info()
+    {
+        var header = ringPtr >> 2,
+            heap = Module.HEAPU32,
+            capacity = heap[header],
+            written = heap[header + 1],
+            read = heap[header + 2],
+            view,
+            offset;
+        
+        if (read === written) {
+            return;
+        }
+        
+        ///NOTE: The heap may have grown since the last time, so get a new view every time.
+        view = new DataView(heap.buffer);
+        
+        while (read !== written) {
+            offset = ringPtr + 16 + read % capacity;
+            
+            /// Skip padding (type 0).
+            if (view.getUint8(offset + 2) === 1) {
+                if (workerObj.oninfo) {
+                    workerObj.oninfo(new InfoRecord(view, offset));
+                } else {
+                    emit(String(new InfoRecord(view, offset)));
+                }
+            }
+            
+            read = (read + view.getUint16(offset, true)) >>> 0;
+        }
+        
+        heap[header + 2] = read;
+    }
     
     myConsole = {
         log: function log(line)
         {
-            if (workerObj.onmessage) {
-                /// Match Web Workers.
-                workerObj.onmessage(line)
-            } else {
-                console.error("You must set onmessage");
-                console.info(line);
+            /// Keep the order: any info records come before this line.
+            if (ringPtr) {
+                read_info();
             }
+            emit(line);
         },
         time: function time(s)
         {
@@ -221,24 +356,56 @@ return function (WasmPath)
     
     myConsole.warn = myConsole.log;
     
+    /// Runs the queued commands in order. While the search sleeps, the engine turns down (returns 1) the commands
+    /// that would disturb it. They keep their place and are tried again later. Only "stop" and "ponderhit" may get
+    /// through ahead of them: "isready" and "uci" must still answer after all the commands sent before them.
+    function drain()
+    {
+        var i,
+            turnedDown = false;
+        
+        if (!Module) {
+            schedule(100);
+            return;
+        }
+        for (i = 0; i < cmds.length; i += 1) {
+            if (turnedDown && !/^\s*(stop|ponderhit)\b/.test(cmds[i])) {
+                continue;
+            }
+            if (!Module.ccall("uci_command", "number", ["string"], [cmds[i]])) {
+                cmds.splice(i, 1);
+                i -= 1;
+            } else {
+                turnedDown = true;
+            }
+        }
+        if (cmds.length) {
+            /// Not setImmediate(): the search sleeps on a timer, and the retries must not keep the event loop busy.
+            schedule(1);
+        }
+    }
+    
+    /// There is at most one pending drain, however many commands are waiting.
+    function schedule(delay)
+    {
+        if (!drainTimer) {
+            drainTimer = setTimeout(function ()
+            {
+                drainTimer = null;
+                drain();
+            }, delay);
+        }
+    }
+    
     workerObj = {
         postMessage: function sendMessage(str, sync)
         {
-            function ccall()
-            {
-                if (Module) {
-                    Module.ccall("uci_command", "number", ["string"], [cmds.shift()]);
-                } else {
-                    setTimeout(ccall, 100);
-                }
-            }
-            
             cmds.push(str);
             
             if (sync) {
-                ccall();
+                drain();
             } else {
-                wait(ccall, 1);
+                schedule(1);
             }
         }
     };
@@ -257,6 +424,14 @@ return function (WasmPath)
         
         /// Initialize.
         Module.ccall("init", "number", [], []);
+        
+        /// With the "Binary Info" option, the PV info comes through the info ring. It is also read
+        /// before each line of text, and the search gives way to this timer often (see ASYNC_YIELD).
+        ringPtr = Module.ccall("info_ring", "number", [], []);
+        infoTimer = setInterval(read_info, 10);
+        if (infoTimer.unref) {
+            infoTimer.unref();
+        }
     }, 1);
     
     return workerObj;
@@ -284,6 +459,7 @@ return function (WasmPath)
             "position startpos",
             "position startpos moves",
             "quit",
+            "setoption name Binary Info value true",
             "setoption name Clear Hash value ",
             "setoption name Contempt value ",
             "setoption name Hash value ",
@@ -23,8 +23,10 @@
 #endif
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstddef>   // For offsetof
 #include <cstring>   // For std::memset
 #include <iostream>
 #include <sstream>
@@ -249,17 +251,55 @@ namespace {
                      : VALUE_DRAW + Value(2 * (thisThread->nodes.load(std::memory_order_relaxed) % 2) - 1);
   }
 
-  // Skill structure is used to implement strength limit
-  struct Skill {
-    explicit Skill(int l) : level(l) {}
-    bool enabled() const { return level < 20; }
-    bool time_to_pick(Depth depth) const { return depth / ONE_PLY == 1 + level; }
-    Move pick_best(size_t multiPV);
+  // ThreadHolding structure keeps track of which thread left breadcrumbs at the given
+  // node for potential reductions. A free node will be marked upon entering the moves
+  // loop by the constructor, and unmarked upon leaving that loop by the destructor.
+  // Nodes are only marked with the ABDADA scheduler, the only one reading the marks.
+  struct ThreadHolding {
+    explicit ThreadHolding(Thread* thisThread, Key posKey, int ply, bool abdada) {
+       auto& breadcrumbs = Threads.breadcrumbs;
+       location = abdada && ply < 8 ? &breadcrumbs[posKey & (breadcrumbs.size() - 1)] : nullptr;
+       otherThread = false;
+       owning = false;
+       if (location)
+       {
+          // See if another already marked this location, if not, mark it ourselves
+          Thread* tmp = (*location).thread.load(std::memory_order_relaxed);
+          if (tmp == nullptr)
+          {
+              (*location).thread.store(thisThread, std::memory_order_relaxed);
+              (*location).key.store(posKey, std::memory_order_relaxed);
+              owning = true;
+          }
+          else if (   tmp != thisThread
+                   && (*location).key.load(std::memory_order_relaxed) == posKey)
+              otherThread = true;
+       }
+    }
 
-    int level;
-    Move best = MOVE_NONE;
+    ~ThreadHolding() {
+       if (owning) // Free the marked location
+           (*location).thread.store(nullptr, std::memory_order_relaxed);
+    }
+
+    bool marked() { return otherThread; }
+
+    private:
+    ThreadPool::Breadcrumb* location;
+    bool otherThread, owning;
   };
 
+  // searched_elsewhere() tells whether another thread has marked the node with
+  // the given key, so that the ABDADA scheduler can put off moves leading to it
+  bool searched_elsewhere(const Thread* thisThread, Key key) {
+
+    const auto& breadcrumbs = Threads.breadcrumbs;
+    const ThreadPool::Breadcrumb& b = breadcrumbs[key & (breadcrumbs.size() - 1)];
+    const Thread* tmp = b.thread.load(std::memory_order_relaxed);
+
+    return tmp && tmp != thisThread && b.key.load(std::memory_order_relaxed) == key;
+  }
+
   template <NodeType NT>
   Value search(Position& pos, Stack* ss, Value alpha, Value beta, Depth depth, bool cutNode);
 
@@ -272,6 +312,8 @@ namespace {
   void update_continuation_histories(Stack* ss, Piece pc, Square to, int bonus);
   void update_quiet_stats(const Position& pos, Stack* ss, Move move, Move* quiets, int quietsCnt, int bonus);
   void update_capture_stats(const Position& pos, Move move, Move* captures, int captureCnt, int bonus);
+  void print_pv(const Position& pos, Depth depth, Value alpha, Value beta, bool final = false);
+  bool info_due(size_t idx, TimePoint elapsed, int rate);
 
   inline bool gives_check(const Position& pos, Move move) {
     Color us = pos.side_to_move();
@@ -370,15 +412,17 @@ void Search::clear() {
 #endif
 
   Time.availableNodes = 0;
-  TT.clear();
+
+  // A file backed hash is meant to be kept across games, so that only an
+  // explicit "Clear Hash" empties it.
+  if (!TT.persistent())
+      TT.clear();
   Threads.clear();
 #ifndef __EMSCRIPTEN__
   Tablebases::init(CHESS_VARIANT, Options["SyzygyPath"]); // Free up mapped files
 #endif
 }
 
-Color us_;
-
 /// MainThread::search() is called by the main thread when the program receives
 /// the UCI 'go' command. It searches from the root position and outputs the "bestmove".
 
@@ -391,9 +435,11 @@ void MainThread::search() {
       return;
   }
 
-  us_ = rootPos.side_to_move();
-  Time.init(rootPos.variant(), Limits, us_, rootPos.game_ply());
+  us = rootPos.side_to_move();
+  Time.init(rootPos.variant(), Limits, us, rootPos.game_ply());
   TT.new_search();
+  lastInfo.clear();
+  infoHeld = false;
 
   if (rootMoves.empty())
   {
@@ -419,13 +465,12 @@ void MainThread::after_search() {
   // When we reach the maximum depth, we can arrive here without a raise of
   // Threads.stop. However, if we are pondering or in an infinite search,
   // the UCI protocol states that we shouldn't print the best move before the
-  // GUI sends a "stop" or "ponderhit" command. We therefore simply wait here
-  // until the GUI sends one of those commands (which also raises Threads.stop).
+  // GUI sends a "stop" or "ponderhit" command. We therefore sleep here until
+  // the GUI sends one of those commands (which also raises Threads.stop).
   Threads.stopOnPonderhit = true;
 
 #ifndef __EMSCRIPTEN__
-  while (!Threads.stop && (Threads.ponder || Limits.infinite))
-  {} // Busy wait for a stop or a ponder reset
+  Threads.wait_for_stop();
 #endif
 
   // Stop the threads if not already stopped (also raise the stop if
@@ -440,7 +485,7 @@ void MainThread::after_search() {
   // When playing in 'nodes as time' mode, subtract the searched nodes from
   // the available ones before exiting.
   if (Limits.npmsec)
-      Time.availableNodes += Limits.inc[us_] - Threads.nodes_searched();
+      Time.availableNodes += Limits.inc[us] - Threads.nodes_searched();
 
   // Check if there are threads with a better score than main thread
   Thread* bestThread = this;
@@ -480,13 +525,17 @@ void MainThread::after_search() {
 
 #ifdef USELONGESTPV
   if (longestPVThread != this)
-      sync_cout << UCI::pv(longestPVThread->rootPos, longestPVThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE) << sync_endl;
+      print_pv(longestPVThread->rootPos, longestPVThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE);
 #else
   // Send again PV info if we have a new best thread
   if (bestThread != this)
-      sync_cout << UCI::pv(bestThread->rootPos, bestThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE) << sync_endl;
+      print_pv(bestThread->rootPos, bestThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE);
 #endif
 
+  // Let the GUI see the last PV if the rate limit has held it back
+  if (infoHeld)
+      print_pv(bestThread->rootPos, bestThread->completedDepth, -VALUE_INFINITE, VALUE_INFINITE, true);
+
   // Best move could be MOVE_NONE when searching on a terminal position
   sync_cout << "bestmove " << UCI::move(bestThread->rootMoves[0].pv[0], rootPos.is_chess960());
 
@@ -501,16 +550,6 @@ void MainThread::after_search() {
 /// repeatedly with increasing depth until the allocated thinking time has been
 /// consumed, the user stops the search, or the maximum search depth is reached.
 
-Stack stack_[MAX_PLY+7], *ss_ = stack_ + 4; // To reference from (ss-4) and (ss+2)
-Value bestValue_, alpha_, beta_, delta_;
-Move lastBestMove_;
-Depth lastBestMoveDepth_;
-MainThread* mainThread_;
-double timeReduction_;
-size_t multiPV_;
-Skill skill_(Options["Skill Level"]);
-bool failedLow_;
-
 void search_iteration_call(void *thread) {
   ((Thread *)thread)->search_iteration();
 }
@@ -520,11 +559,11 @@ void after_search_call(void *mainThread) {
 }
 
 void Thread::search() {
-  lastBestMove_ = MOVE_NONE;
-  lastBestMoveDepth_ = DEPTH_ZERO;
-  mainThread_ = (this == Threads.main() ? Threads.main() : nullptr);
-  timeReduction_ = 1.0;
-  us_ = rootPos.side_to_move();
+  lastBestMove = MOVE_NONE;
+  lastBestMoveDepth = DEPTH_ZERO;
+  mainThread = (this == Threads.main() ? Threads.main() : nullptr);
+  timeReduction = 1.0;
+  us = rootPos.side_to_move();
 
 #ifdef CHESSCOM
  if (Limits.smartdepth) {
@@ -532,30 +571,30 @@ void Thread::search() {
  }
 #endif
 
-  std::memset(ss_-4, 0, 7 * sizeof(Stack));
+  std::memset(ss-4, 0, 7 * sizeof(Stack));
   for (int i = 4; i > 0; i--)
-     (ss_-i)->continuationHistory = &this->continuationHistory[NO_PIECE][0]; // Use as sentinel
+     (ss-i)->continuationHistory = &this->continuationHistory[NO_PIECE][0]; // Use as sentinel
 
-  bestValue_ = delta_ = alpha_ = -VALUE_INFINITE;
-  beta_ = VALUE_INFINITE;
+  bestValue = delta = alpha = -VALUE_INFINITE;
+  beta = VALUE_INFINITE;
 
-  if (mainThread_)
-      mainThread_->bestMoveChanges = 0, failedLow_ = false;
+  if (mainThread)
+      mainThread->bestMoveChanges = 0, failedLow = false;
 
-  multiPV_ = Options["MultiPV"];
-  skill_ = Skill(Options["Skill Level"]);
+  multiPV = Options["MultiPV"];
+  skill = Skill(Options["Skill Level"]);
 
   // When playing with strength handicap enable MultiPV search that we will
   // use behind the scenes to retrieve a set of possible moves.
-  if (skill_.enabled())
+  if (skill.enabled())
 #ifdef CHESSCOM
 /// The bigger multiPV is, the more bad moves will be avaiable to choose from.
-      multiPV_ = std::max(multiPV_, (size_t)5);
+      multiPV = std::max(multiPV, (size_t)5);
 #else
-      multiPV_ = std::max(multiPV_, (size_t)4);
+      multiPV = std::max(multiPV, (size_t)4);
 #endif
 
-  multiPV_ = std::min(multiPV_, rootMoves.size());
+  multiPV = std::min(multiPV, rootMoves.size());
 
 #ifdef __EMSCRIPTEN__
   emscripten_async_call(search_iteration_call, this, 0);
@@ -571,12 +610,12 @@ void Thread::search_iteration() {
   if (Limits.infinite || Options["UCI_AnalyseMode"])
       ct =  Options["Analysis Contempt"] == "Off"  ? 0
           : Options["Analysis Contempt"] == "Both" ? ct
-          : Options["Analysis Contempt"] == "White" && us_ == BLACK ? -ct
-          : Options["Analysis Contempt"] == "Black" && us_ == WHITE ? -ct
+          : Options["Analysis Contempt"] == "White" && us == BLACK ? -ct
+          : Options["Analysis Contempt"] == "Black" && us == WHITE ? -ct
           : ct;
 
   // In evaluate.cpp the evaluation is from the white point of view
-  contempt = (us_ == WHITE ?  make_score(ct, ct / 2)
+  contempt = (us == WHITE ?  make_score(ct, ct / 2)
                            : -make_score(ct, ct / 2));
 
   // Iterative deepening loop until requested to stop or the target depth is reached
@@ -585,13 +624,33 @@ void Thread::search_iteration() {
          && (rootDepth) <= Limits.maxdepth
 #endif
          && !Threads.stop
-         && !(Limits.depth && mainThread_ && rootDepth / ONE_PLY > Limits.depth))
+         && !(Limits.depth && (mainThread || independent) && rootDepth / ONE_PLY > Limits.depth))
   {
-      // Distribute search depths across the helper threads
-      if (idx > 0)
+      // Distribute search depths across the helper threads. By default with
+      // the skip-blocks, with "Depth Ratio" a helper skips a depth that at
+      // least the given percentage of the threads have reached already. With
+      // "ABDADA" all threads search all depths, and split the work by putting
+      // off the moves that other threads are searching.
+      if (idx > 0 && !independent)
       {
           int i = (idx - 1) % 20;
-          if (((rootDepth / ONE_PLY + SkipPhase[i]) / SkipSize[i]) % 2) {
+          bool skip;
+
+          switch (Threads.scheduler) {
+          case ThreadPool::NO_SKIP:
+          case ThreadPool::ABDADA:
+              skip = false;
+              break;
+          case ThreadPool::DEPTH_RATIO:
+              skip =  std::count_if(Threads.begin(), Threads.end(), [&](Thread* th) {
+                          return th != this && th->rootDepth >= rootDepth; }) * 100
+                   >= Threads.depthRatio * int(Threads.size());
+              break;
+          default:
+              skip = ((rootDepth / ONE_PLY + SkipPhase[i]) / SkipSize[i]) % 2;
+          }
+
+          if (skip) {
               // Retry with an incremented rootDepth
 #ifdef __EMSCRIPTEN__
               emscripten_async_call(search_iteration_call, this, 0);
@@ -603,8 +662,8 @@ void Thread::search_iteration() {
       }
 
       // Age out PV variability metric
-      if (mainThread_)
-          mainThread_->bestMoveChanges *= 0.517, failedLow_ = false;
+      if (mainThread)
+          mainThread->bestMoveChanges *= 0.517, failedLow = false;
 
       // Save the last iteration's scores before first PV line is searched and
       // all the move scores except the (new) PV are set to -VALUE_INFINITE.
@@ -615,7 +674,7 @@ void Thread::search_iteration() {
       pvLast = 0;
 
       // MultiPV loop. We perform a full root search for each PV line
-      for (pvIdx = 0; pvIdx < multiPV_ && !Threads.stop; ++pvIdx)
+      for (pvIdx = 0; pvIdx < multiPV && !Threads.stop; ++pvIdx)
       {
           if (pvIdx == pvLast)
           {
@@ -632,14 +691,14 @@ void Thread::search_iteration() {
           if (rootDepth >= 5 * ONE_PLY)
           {
               Value previousScore = rootMoves[pvIdx].previousScore;
-              delta_ = Value(20);
-              alpha_ = std::max(previousScore - delta_,-VALUE_INFINITE);
-              beta_  = std::min(previousScore + delta_, VALUE_INFINITE);
+              delta = Value(20);
+              alpha = std::max(previousScore - delta,-VALUE_INFINITE);
+              beta  = std::min(previousScore + delta, VALUE_INFINITE);
 
               // Adjust contempt based on root move's previousScore (dynamic contempt)
               int dct = ct + 88 * previousScore / (abs(previousScore) + 200);
 
-              contempt = (us_ == WHITE ?  make_score(dct, dct / 2)
+              contempt = (us == WHITE ?  make_score(dct, dct / 2)
                                        : -make_score(dct, dct / 2));
           }
 
@@ -650,7 +709,7 @@ void Thread::search_iteration() {
           while (true)
           {
               Depth adjustedDepth = std::max(ONE_PLY, rootDepth - failedHighCnt * ONE_PLY);
-              bestValue_ = ::search<PV>(rootPos, ss_, alpha_, beta_, adjustedDepth, false);
+              bestValue = ::search<PV>(rootPos, ss, alpha, beta, adjustedDepth, false);
 
               // Bring the best move to the front. It is critical that sorting
               // is done with a stable algorithm because all the values but the
@@ -668,36 +727,36 @@ void Thread::search_iteration() {
 
               // When failing high/low give some update (without cluttering
               // the UI) before a re-search.
-              if (   mainThread_
-                  && multiPV_ == 1
-                  && (bestValue_ <= alpha_ || bestValue_ >= beta_)
+              if (   mainThread
+                  && multiPV == 1
+                  && (bestValue <= alpha || bestValue >= beta)
                   && Time.elapsed() > PV_MIN_ELAPSED)
-                  sync_cout << UCI::pv(rootPos, rootDepth, alpha_, beta_) << sync_endl;
+                  print_pv(rootPos, rootDepth, alpha, beta);
 
               // In case of failing low/high increase aspiration window and
               // re-search, otherwise exit the loop.
-              if (bestValue_ <= alpha_)
+              if (bestValue <= alpha)
               {
-                  beta_ = (alpha_ + beta_) / 2;
-                  alpha_ = std::max(bestValue_ - delta_, -VALUE_INFINITE);
+                  beta = (alpha + beta) / 2;
+                  alpha = std::max(bestValue - delta, -VALUE_INFINITE);
 
-                  if (mainThread_)
+                  if (mainThread)
                   {
                       failedHighCnt = 0;
-                      failedLow_ = true;
+                      failedLow = true;
                       Threads.stopOnPonderhit = false;
                   }
               }
-              else if (bestValue_ >= beta_)
+              else if (bestValue >= beta)
               {
-                  beta_ = std::min(bestValue_ + delta_, VALUE_INFINITE);
-                  if (mainThread_)
+                  beta = std::min(bestValue + delta, VALUE_INFINITE);
+                  if (mainThread)
                 	  ++failedHighCnt;
               }
               else
                   break;
 
-              delta_ += delta_ / 4 + 5;
+              delta += delta / 4 + 5;
 
               assert(alpha >= -VALUE_INFINITE && beta <= VALUE_INFINITE);
           }
@@ -705,26 +764,26 @@ void Thread::search_iteration() {
           // Sort the PV lines searched so far and update the GUI
           std::stable_sort(rootMoves.begin() + pvFirst, rootMoves.begin() + pvIdx + 1);
 
-          if (    mainThread_
-              && (Threads.stop || pvIdx + 1 == multiPV_ || Time.elapsed() > PV_MIN_ELAPSED))
-              sync_cout << UCI::pv(rootPos, rootDepth, alpha_, beta_) << sync_endl;
+          if (    mainThread
+              && (Threads.stop || pvIdx + 1 == multiPV || Time.elapsed() > PV_MIN_ELAPSED))
+              print_pv(rootPos, rootDepth, alpha, beta);
       }
 
       if (!Threads.stop)
           completedDepth = rootDepth;
 
-      if (rootMoves[0].pv[0] != lastBestMove_) {
-         lastBestMove_ = rootMoves[0].pv[0];
-         lastBestMoveDepth_ = rootDepth;
+      if (rootMoves[0].pv[0] != lastBestMove) {
+         lastBestMove = rootMoves[0].pv[0];
+         lastBestMoveDepth = rootDepth;
       }
 
       // Have we found a "mate in x"?
       if (   Limits.mate
-          && bestValue_ >= VALUE_MATE_IN_MAX_PLY
-          && VALUE_MATE - bestValue_ <= 2 * Limits.mate)
+          && bestValue >= VALUE_MATE_IN_MAX_PLY
+          && VALUE_MATE - bestValue <= 2 * Limits.mate)
           Threads.stop = true;
 
-      if (!mainThread_) {
+      if (!mainThread) {
 #ifdef __EMSCRIPTEN__
           emscripten_async_call(search_iteration_call, this, 0);
 #else
@@ -734,11 +793,11 @@ void Thread::search_iteration() {
       }
 
       // If skill level is enabled and time is up, pick a sub-optimal best move
-      if (skill_.enabled() && skill_.time_to_pick(rootDepth))
-          skill_.pick_best(multiPV_);
+      if (skill.enabled() && skill.time_to_pick(rootDepth))
+          skill.pick_best(rootMoves, multiPV);
 
 #ifdef CHESSCOM
-      if (Limits.smartdepth && rootDepth >= minSmartDepth && Time.elapsed() >= Limits.mintime && mainThread_->bestMoveChanges < std::min(Limits.confidence * 10, Limits.confidence * (std::max(1, rootDepth - minSmartDepth)))) {
+      if (Limits.smartdepth && rootDepth >= minSmartDepth && Time.elapsed() >= Limits.mintime && mainThread->bestMoveChanges < std::min(Limits.confidence * 10, Limits.confidence * (std::max(1, rootDepth - minSmartDepth)))) {
           Threads.stop = true;
       }
 #endif
@@ -748,20 +807,20 @@ void Thread::search_iteration() {
           && !Threads.stop
           && !Threads.stopOnPonderhit)
           {
-              const int F[] = { failedLow_,
-                                bestValue_ - mainThread_->previousScore };
+              const int F[] = { failedLow,
+                                bestValue - mainThread->previousScore };
 
               int improvingFactor = std::max(246, std::min(832, 306 + 119 * F[0] - 6 * F[1]));
 
               // If the bestMove is stable over several iterations, reduce time accordingly
-              timeReduction_ = 1.0;
+              timeReduction = 1.0;
               for (int i : {3, 4, 5})
-                  if (lastBestMoveDepth_ * i < completedDepth)
-                     timeReduction_ *= 1.25;
+                  if (lastBestMoveDepth * i < completedDepth)
+                     timeReduction *= 1.25;
 
               // Use part of the gained time from a previous stable move for the current move
-              double bestMoveInstability = 1.0 + mainThread_->bestMoveChanges;
-              bestMoveInstability *= std::pow(mainThread_->previousTimeReduction, 0.528) / timeReduction_;
+              double bestMoveInstability = 1.0 + mainThread->bestMoveChanges;
+              bestMoveInstability *= std::pow(mainThread->previousTimeReduction, 0.528) / timeReduction;
 
               // Stop the search if we have only one legal move, or if available time elapsed
               if (   rootMoves.size() == 1
@@ -799,21 +858,21 @@ void Thread::search_iteration() {
       return;
   }
 
-  if (!mainThread_)
+  if (!mainThread)
       return;
 
-  mainThread_->previousTimeReduction = timeReduction_;
+  mainThread->previousTimeReduction = timeReduction;
 
   // If skill level is enabled, swap best PV line with the sub-optimal one
-  if (skill_.enabled())
+  if (skill.enabled())
       std::swap(rootMoves[0], *std::find(rootMoves.begin(), rootMoves.end(),
-                skill_.best ? skill_.best : skill_.pick_best(multiPV_)));
+                skill.best ? skill.best : skill.pick_best(rootMoves, multiPV)));
 
-  if (mainThread_) {
+  if (mainThread) {
 #ifdef __EMSCRIPTEN__
-      emscripten_async_call(after_search_call, mainThread_, 0);
+      emscripten_async_call(after_search_call, mainThread, 0);
 #else
-      mainThread_->after_search();
+      mainThread->after_search();
 #endif
   }
 }
@@ -852,7 +911,7 @@ namespace {
     assert(!(PvNode && cutNode));
     assert(depth / ONE_PLY * ONE_PLY == depth);
 
-    Move pv[MAX_PLY+1], capturesSearched[32], quietsSearched[64];
+    Move pv[MAX_PLY+1], capturesSearched[32], quietsSearched[64], deferred[16];
     StateInfo st;
     TTEntry* tte;
     Key posKey;
@@ -929,6 +988,9 @@ namespace {
     excludedMove = ss->excludedMove;
     posKey = pos.key() ^ Key(excludedMove << 16); // Isn't a very good hash
     tte = TT.probe(posKey, ttHit);
+#ifdef TT_STATS
+    thisThread->ttProbes++, thisThread->ttHits += ttHit;
+#endif
     ttValue = ttHit ? value_from_tt(tte->value(), ss->ply) : VALUE_NONE;
     ttMove =  rootNode ? thisThread->rootMoves[thisThread->pvIdx].pv[0]
             : ttHit    ? tte->move() : MOVE_NONE;
@@ -1235,6 +1297,14 @@ namespace {
 
 moves_loop: // When in check, search starts from here
 
+    // With the ABDADA scheduler, mark this node as being searched, and put off
+    // moves into nodes that another thread is searching until all the other
+    // moves have been searched.
+    const bool abdada = Threads.scheduler == ThreadPool::ABDADA;
+    ThreadHolding th(thisThread, posKey, ss->ply, abdada);
+    const bool deferring = abdada && !rootNode && ss->ply < 7;
+    int deferredCount = 0, deferredIdx = 0;
+
     const PieceToHistory* contHist[] = { (ss-1)->continuationHistory, (ss-2)->continuationHistory, nullptr, (ss-4)->continuationHistory };
     Move countermove = thisThread->counterMoves[pos.piece_on(prevSq)][prevSq];
 
@@ -1251,13 +1321,24 @@ moves_loop: // When in check, search starts from here
 
     // Step 12. Loop through all pseudo-legal moves until no moves remain
     // or a beta cutoff occurs.
-    while ((move = mp.next_move(skipQuiets)) != MOVE_NONE)
+    while (   (move = mp.next_move(skipQuiets)) != MOVE_NONE
+           || (deferredIdx < deferredCount && (move = deferred[deferredIdx++]) != MOVE_NONE))
     {
       assert(is_ok(move));
 
       if (move == excludedMove)
           continue;
 
+      if (   deferring
+          && moveCount
+          && !deferredIdx
+          && deferredCount < 16
+          && searched_elsewhere(thisThread, pos.key_after(move)))
+      {
+          deferred[deferredCount++] = move;
+          continue;
+      }
+
       // At root obey the "searchmoves" option and skip moves not listed in Root
       // Move List. As a consequence any illegal move is also skipped. In MultiPV
       // mode we also skip PV moves which have been already searched and those
@@ -1391,6 +1472,9 @@ moves_loop: // When in check, search starts from here
 
       // Speculative prefetch as early as possible
       prefetch(TT.first_entry(pos.key_after(move)));
+#ifdef PREFETCH_AHEAD
+      mp.prefetch_ahead();
+#endif
 
       // Check for legality just before making the move
       if (!rootNode && !pos.legal(move))
@@ -1423,6 +1507,11 @@ moves_loop: // When in check, search starts from here
           if ((ss-1)->moveCount > 15)
               r -= ONE_PLY;
 
+          // Increase reduction if other threads are searching this position,
+          // only ever the case with the ABDADA scheduler
+          if (th.marked())
+              r += ONE_PLY;
+
           if (!captureOrPromotion)
           {
               // Decrease reduction for exact PV nodes (~0 Elo)
@@ -1640,7 +1729,7 @@ moves_loop: // When in check, search starts from here
     Move ttMove, move, bestMove;
     Depth ttDepth;
     Value bestValue, value, ttValue, futilityValue, futilityBase, oldAlpha;
-    bool ttHit, inCheck, givesCheck, evasionPrunable;
+    bool ttHit, inCheck, givesCheck, evasionPrunable, windowCut = false;
     int moveCount;
 
     if (PvNode)
@@ -1678,6 +1767,9 @@ moves_loop: // When in check, search starts from here
     // Transposition table lookup
     posKey = pos.key();
     tte = TT.probe(posKey, ttHit);
+#ifdef TT_STATS
+    thisThread->ttProbes++, thisThread->ttHits += ttHit;
+#endif
     ttValue = ttHit ? value_from_tt(tte->value(), ss->ply) : VALUE_NONE;
     ttMove = ttHit ? tte->move() : MOVE_NONE;
 
@@ -1701,7 +1793,7 @@ moves_loop: // When in check, search starts from here
         {
             // Never assume anything on values stored in TT
             if ((ss->staticEval = bestValue = tte->eval()) == VALUE_NONE)
-                ss->staticEval = bestValue = evaluate(pos);
+                ss->staticEval = bestValue = evaluate(pos, alpha, beta, &windowCut);
 
             // Can ttValue be used as a better position evaluation?
             if (    ttValue != VALUE_NONE
@@ -1710,9 +1802,14 @@ moves_loop: // When in check, search starts from here
         }
         else
             ss->staticEval = bestValue =
-            (ss-1)->currentMove != MOVE_NULL ? evaluate(pos)
+            (ss-1)->currentMove != MOVE_NULL ? evaluate(pos, alpha, beta, &windowCut)
                                              : -(ss-1)->staticEval + 2 * Eval::Tempo[pos.variant()];
 
+        // An evaluation cut short by the window is no static eval to keep in
+        // the TT, where search() would take it for an exact one.
+        if (windowCut)
+            ss->staticEval = VALUE_NONE;
+
         // Stand pat. Return immediately if static value is at least beta
         if (bestValue >= beta)
         {
@@ -1801,6 +1898,9 @@ moves_loop: // When in check, search starts from here
 
       // Speculative prefetch as early as possible
       prefetch(TT.first_entry(pos.key_after(move)));
+#ifdef PREFETCH_AHEAD
+      mp.prefetch_ahead();
+#endif
 
       // Check for legality just before making the move
       if (!pos.legal(move))
@@ -1953,73 +2053,132 @@ moves_loop: // When in check, search starts from here
     }
   }
 
-  // When playing with strength handicap, choose best move among a set of RootMoves
-  // using a statistical rule dependent on 'level'. Idea by Heinz van Saanen.
+  // print_pv() sends the PV info to the GUI, as text lines or, in the JS build
+  // with the "Binary Info" option, as records in the info ring. A final update
+  // is never held back by the "Info Rate Limit" option.
+
+  void print_pv(const Position& pos, Depth depth, Value alpha, Value beta, bool final) {
+
+    if (final)
+        Threads.main()->infoHeld = false;
+
+#ifdef __EMSCRIPTEN__
+    if (Options["Binary Info"])
+    {
+        UCI::pv_records(pos, depth, alpha, beta, final);
+        return;
+    }
+#endif
+
+    string info = UCI::pv(pos, depth, alpha, beta, final);
+
+    if (!info.empty())
+        sync_cout << info << sync_endl;
+  }
+
 
-  Move Skill::pick_best(size_t multiPV) {
+  // info_due() checks whether an update of the MultiPV line 'idx' may be sent
+  // now, when at most 'rate' updates per second are allowed (0 means no limit).
+  // If not, it remembers that the GUI has missed something.
 
-    const RootMoves& rootMoves = Threads.main()->rootMoves;
-    static PRNG rng(now()); // PRNG sequence should be non-deterministic
+  bool info_due(size_t idx, TimePoint elapsed, int rate) {
 
-    // RootMoves are already sorted by score in descending order
-    Value topScore = rootMoves[0].score;
-    int delta = std::min(topScore - rootMoves[multiPV - 1].score, PawnValueMg);
-    int weakness = 125 - level * 9/4;
-    int maxScore = -VALUE_INFINITE;
+    MainThread* mainThread = Threads.main();
+    std::vector<TimePoint>& lastInfo = mainThread->lastInfo;
+
+    if (lastInfo.size() <= idx)
+        lastInfo.resize(idx + 1, -1000);
+
+    if (rate && elapsed - lastInfo[idx] < 1000 / rate)
+    {
+        mainThread->infoHeld = true;
+        return false;
+    }
+
+    lastInfo[idx] = elapsed;
+    return true;
+  }
+
+} // namespace
+
+
+/// When playing with strength handicap, choose best move among a set of RootMoves
+/// using a statistical rule dependent on 'level'. Idea by Heinz van Saanen.
+
+Move Skill::pick_best(const RootMoves& rootMoves, size_t multiPV) {
+
+  static PRNG rng(now()); // PRNG sequence should be non-deterministic
+
+  // RootMoves are already sorted by score in descending order
+  Value topScore = rootMoves[0].score;
+  int delta = std::min(topScore - rootMoves[multiPV - 1].score, PawnValueMg);
+  int weakness = 125 - level * 9/4;
+  int maxScore = -VALUE_INFINITE;
 
 #ifdef CHESSCOM
-    weakness = 120 - 2 * level;
+  weakness = 120 - 2 * level;
 #endif
 
-    // Choose best move. For each move score we add two terms, both dependent on
-    // weakness. One is deterministic and bigger for weaker levels, and one is
-    // random. Then we choose the move with the resulting highest score.
-    for (size_t i = 0; i < multiPV; ++i)
-    {
+  // Choose best move. For each move score we add two terms, both dependent on
+  // weakness. One is deterministic and bigger for weaker levels, and one is
+  // random. Then we choose the move with the resulting highest score.
+  for (size_t i = 0; i < multiPV; ++i)
+  {
 #ifdef CHESSCOM
-        int score = rootMoves[i].score;
+      int score = rootMoves[i].score;
 
-        // Extra protection in case the score was cleared.
-        if (score == -32001 || score == 32001) {
-            continue;
-        }
+      // Extra protection in case the score was cleared.
+      if (score == -32001 || score == 32001) {
+          continue;
+      }
 
-        // Do allow crazy blunders at very low skills
-        if (i > 0 && rootMoves[i - 1].score > score + (int(Options["Skill Level Maximum Error"]) * PawnValueMg) / 100)
-            break;
+      // Do allow crazy blunders at very low skills
+      if (i > 0 && rootMoves[i - 1].score > score + (int(Options["Skill Level Maximum Error"]) * PawnValueMg) / 100)
+          break;
 
-        // This is our magic formula
-        score += (  weakness * int(topScore - score)
-                  + delta * (rng.rand<unsigned>() % weakness)) / Options["Skill Level Probability"];
+      // This is our magic formula
+      score += (  weakness * int(topScore - score)
+                + delta * (rng.rand<unsigned>() % weakness)) / Options["Skill Level Probability"];
 
-        if (score > maxScore)
-        {
-            maxScore = score;
-            best = rootMoves[i].pv[0];
-        }
+      if (score > maxScore)
+      {
+          maxScore = score;
+          best = rootMoves[i].pv[0];
+      }
 #else
-        // This is our magic formula
-        int push = (  weakness * int(topScore - rootMoves[i].score)
-                    + delta * (rng.rand<unsigned>() % weakness)) / 128;
+      // This is our magic formula
+      int push = (  weakness * int(topScore - rootMoves[i].score)
+                  + delta * (rng.rand<unsigned>() % weakness)) / 128;
 
-        if (rootMoves[i].score + push >= maxScore)
-        {
-            maxScore = rootMoves[i].score + push;
-            best = rootMoves[i].pv[0];
-        }
+      if (rootMoves[i].score + push >= maxScore)
+      {
+          maxScore = rootMoves[i].score + push;
+          best = rootMoves[i].pv[0];
+      }
 #endif
-    }
-
-    return best;
   }
 
-} // namespace
+  return best;
+}
+
 
 /// MainThread::check_time() is used to print debug info and, more importantly,
 /// to detect when we are out of available time and thus stop the search.
 
 void MainThread::check_time() {
 
+#ifdef ASYNC_YIELD
+  // Hand control back to the event loop every ASYNC_YIELD nodes, so that a
+  // "stop" or "ponderhit" is handled in bounded time even within an iteration.
+  if (nodes >= nextYield)
+  {
+      nextYield = nodes + ASYNC_YIELD;
+      yielding = true;
+      emscripten_sleep(0);
+      yielding = false;
+  }
+#endif
+
   if (--callsCnt > 0)
       return;
 
@@ -2059,8 +2218,12 @@ void MainThread::check_time() {
 
 /// UCI::pv() formats PV information according to the UCI protocol. UCI requires
 /// that all (if any) unsearched PV lines are sent using a previous search score.
+/// With the "Info Format" option set to JSON each line is a JSON object instead,
+/// with the same fields in a fixed order, so that it can be read without parsing
+/// the UCI grammar. Lines held back by the "Info Rate Limit" option are skipped,
+/// which may leave nothing to send.
 
-string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
+string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta, bool final) {
 
   std::stringstream ss;
   TimePoint elapsed = Time.elapsed() + 1;
@@ -2068,6 +2231,9 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
   size_t pvIdx = pos.this_thread()->pvIdx;
   size_t multiPV = std::min((size_t)Options["MultiPV"], rootMoves.size());
   uint64_t nodesSearched = Threads.nodes_searched();
+  bool json = Options["Info Format"] == "JSON";
+  int rate = final ? 0 : int(Options["Info Rate Limit"]);
+  int hashfull = elapsed > 1000 ? TT.hashfull() : -1; // Earlier makes little sense
 #ifndef __EMSCRIPTEN__
   uint64_t tbHits = Threads.tb_hits() + (TB::RootInTB ? rootMoves.size() : 0);
 #endif
@@ -2079,34 +2245,68 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
       if (depth == ONE_PLY && !updated)
           continue;
 
+      if (!info_due(i, elapsed, rate))
+          continue;
+
       Depth d = updated ? depth : depth - ONE_PLY;
       Value v = updated ? rootMoves[i].score : rootMoves[i].previousScore;
+      bool bounded = i == pvIdx;
 
 #ifndef __EMSCRIPTEN__
       bool tb = TB::RootInTB && abs(v) < VALUE_MATE - MAX_PLY;
       v = tb ? rootMoves[i].tbScore : v;
+      bounded = bounded && !tb;
 #endif
       if (ss.rdbuf()->in_avail()) // Not at first line
           ss << "\n";
 
+      if (json)
+      {
+          // Every field is always there, hashfull is -1 while it is not known
+          bool mate = abs(v) >= VALUE_MATE - MAX_PLY;
+
+          ss << "{\"type\":\"info\""
+             << ",\"depth\":"    << d / ONE_PLY
+             << ",\"seldepth\":" << rootMoves[i].selDepth
+             << ",\"multipv\":"  << i + 1
+             << ",\"score\":{"   << (mate ? "\"mate\":" : "\"cp\":")
+             << (mate ? (v > 0 ? VALUE_MATE - v + 1 : -VALUE_MATE - v - 1) / 2 : v * 100 / PawnValueEg)
+             << "},\"bound\":\"" << (bounded && v >= beta ? "lower" : bounded && v <= alpha ? "upper" : "exact")
+             << "\",\"nodes\":"  << nodesSearched
+             << ",\"nps\":"      << nodesSearched * 1000 / elapsed
+             << ",\"hashfull\":" << hashfull
+#ifndef __EMSCRIPTEN__
+             << ",\"tbhits\":"   << tbHits
+#else
+             << ",\"tbhits\":0"
+#endif
+             << ",\"time\":"     << elapsed;
+#ifdef CHESSCOM
+          ss << ",\"bmc\":"      << Threads.main()->bestMoveChanges;
+#endif
+          ss << ",\"pv\":[";
+
+          for (size_t j = 0; j < rootMoves[i].pv.size(); ++j)
+              ss << (j ? ",\"" : "\"") << UCI::move(rootMoves[i].pv[j], pos.is_chess960()) << "\"";
+
+          ss << "]}";
+          continue;
+      }
+
       ss << "info"
          << " depth "    << d / ONE_PLY
          << " seldepth " << rootMoves[i].selDepth
          << " multipv "  << i + 1
          << " score "    << UCI::value(v);
 
-#ifndef __EMSCRIPTEN__
-      if (!tb && i == pvIdx)
-#else
-      if (i == pvIdx)
-#endif
+      if (bounded)
           ss << (v >= beta ? " lowerbound" : v <= alpha ? " upperbound" : "");
 
       ss << " nodes "    << nodesSearched
          << " nps "      << nodesSearched * 1000 / elapsed;
 
-      if (elapsed > 1000) // Earlier makes little sense
-          ss << " hashfull " << TT.hashfull();
+      if (hashfull >= 0)
+          ss << " hashfull " << hashfull;
 
 #ifndef __EMSCRIPTEN__
       ss << " tbhits "   << tbHits
@@ -2118,9 +2318,9 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
 
       for (Move m : rootMoves[i].pv)
           ss << " " << UCI::move(m, pos.is_chess960());
-          
+
 #ifdef CHESSCOM
-        ///NOTE: There are other values, such as "failedLow_" and "previousScore" that could be of use tool
+        ///NOTE: There are other values, such as "failedLow" and "previousScore" that could be of use tool
         ss << " bmc " << Threads.main()->bestMoveChanges;
 #endif
   }
@@ -2129,6 +2329,66 @@ string UCI::pv(const Position& pos, Depth depth, Value alpha, Value beta) {
 }
 
 
+#ifdef __EMSCRIPTEN__
+/// UCI::pv_records() writes the same PV info as UCI::pv() to the info ring, one
+/// record per line. The score is converted as in UCI::value() and the moves as
+/// in UCI::move(), so that the host has no engine internals to know about.
+
+void UCI::pv_records(const Position& pos, Depth depth, Value alpha, Value beta, bool final) {
+
+  InfoRing::PvRecord r;
+  TimePoint elapsed = Time.elapsed() + 1;
+  const RootMoves& rootMoves = pos.this_thread()->rootMoves;
+  size_t pvIdx = pos.this_thread()->pvIdx;
+  size_t multiPV = std::min((size_t)Options["MultiPV"], rootMoves.size());
+  uint64_t nodesSearched = Threads.nodes_searched();
+  int rate = final ? 0 : int(Options["Info Rate Limit"]);
+
+  for (size_t i = 0; i < multiPV; ++i)
+  {
+      bool updated = (i <= pvIdx && rootMoves[i].score != -VALUE_INFINITE);
+
+      if (depth == ONE_PLY && !updated)
+          continue;
+
+      if (!info_due(i, elapsed, rate))
+          continue;
+
+      Depth d = updated ? depth : depth - ONE_PLY;
+      Value v = updated ? rootMoves[i].score : rootMoves[i].previousScore;
+      bool mate = abs(v) >= VALUE_MATE - MAX_PLY;
+
+      r.type = InfoRing::PV;
+      r.flags =  (mate ? InfoRing::MATE : 0)
+               | (i == pvIdx && v >= beta  ? InfoRing::LOWERBOUND
+                : i == pvIdx && v <= alpha ? InfoRing::UPPERBOUND : 0);
+      r.depth = uint16_t(d / ONE_PLY);
+      r.selDepth = uint16_t(rootMoves[i].selDepth);
+      r.multiPV = uint16_t(i + 1);
+      r.hashfull = elapsed > 1000 ? uint16_t(TT.hashfull()) : 0xFFFF;
+      r.score = mate ? (v > 0 ? VALUE_MATE - v + 1 : -VALUE_MATE - v - 1) / 2
+                     : v * 100 / PawnValueEg;
+      r.time = uint32_t(elapsed);
+      r.nodesLo = uint32_t(nodesSearched);
+      r.nodesHi = uint32_t(nodesSearched >> 32);
+#ifdef CHESSCOM
+      r.flags |= InfoRing::BMC;
+      r.bmc = float(Threads.main()->bestMoveChanges);
+#else
+      r.bmc = 0;
+#endif
+      r.pvLength = uint16_t(std::min(rootMoves[i].pv.size(), size_t(MAX_PLY + 1)));
+
+      for (size_t j = 0; j < r.pvLength; ++j)
+          r.pv[j] = UCI::wire_move(rootMoves[i].pv[j], pos.is_chess960());
+
+      r.size = uint16_t((offsetof(InfoRing::PvRecord, pv) + r.pvLength * sizeof(uint16_t) + 3) & ~3);
+      InfoRing::write(&r, r.size);
+  }
+}
+#endif
+
+
 /// RootMove::extract_ponder_from_tt() is called in case we have no ponder move
 /// before exiting the search, for instance, in case we stop the search during a
 /// fail high at root. We try hard to have a ponder move to return to the GUI,
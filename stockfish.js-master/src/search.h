@@ -77,13 +77,26 @@ struct RootMove {
 typedef std::vector<RootMove> RootMoves;
 
 
+/// Skill struct is used to implement strength limit
+
+struct Skill {
+  explicit Skill(int l) : level(l) {}
+  bool enabled() const { return level < 20; }
+  bool time_to_pick(Depth depth) const { return depth / ONE_PLY == 1 + level; }
+  Move pick_best(const RootMoves& rootMoves, size_t multiPV);
+
+  int level;
+  Move best = MOVE_NONE;
+};
+
+
 /// LimitsType struct stores information sent by GUI about available time to
 /// search the current move, maximum depth/time, or if we are in analysis mode.
 
 struct LimitsType {
 
   LimitsType() { // Init explicitly due to broken value-initialization of non POD in MSVC
-    time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = TimePoint(0);
+    time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = startTime = TimePoint(0);
     movestogo = depth = mate = perft = infinite = 0;
     nodes = 0;
 #ifdef CHESSCOM
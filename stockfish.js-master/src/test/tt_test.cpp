@@ -0,0 +1,90 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2008 Tord Romstad (Glaurung author)
+  Copyright (C) 2008-2015 Marco Costalba, Joona Kiiski, Tord Romstad
+  Copyright (C) 2015-2019 Marco Costalba, Joona Kiiski, Gary Linscott, Tord Romstad
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks of the "Two-Tier" replacement of the transposition table, which moves
+// entries within a cluster. Built and run by "make tt-test".
+
+#include <cstdlib>
+#include <iostream>
+
+#include "../tt.h"
+#include "../uci.h"
+
+namespace {
+
+  int failures = 0;
+
+  void check(bool ok, const char* what) {
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+  }
+
+  // Keys with the same 32 low bits share a cluster, the 16 high bits tell them apart
+  Key key_in_cluster(uint16_t tag) { return Key(tag) << 48 | 0x12345; }
+
+} // namespace
+
+int main() {
+
+  UCI::init(Options);
+  TT.resize(1);
+  TT.set_replacement(TranspositionTable::TWO_TIER);
+
+  const Key a = key_in_cluster(0xAAAA), b = key_in_cluster(0xBBBB), c = key_in_cluster(0xCCCC);
+  bool found;
+
+  // A shallow entry of an older search is in the depth-preferred tier
+  TT.probe(a, found)->save(a, VALUE_ZERO, BOUND_EXACT, 4 * ONE_PLY, MOVE_NONE, VALUE_ZERO);
+  TT.new_search();
+
+  // search() saves a node twice through the same pointer: first the static
+  // eval, which takes over the first entry, then the result of the search.
+  TTEntry* tte = TT.probe(b, found);
+  check(!found, "new position is not found");
+  tte->save(b, VALUE_NONE, BOUND_NONE, DEPTH_NONE, MOVE_NONE, VALUE_ZERO);
+  tte->save(b, Value(50), BOUND_LOWER, 8 * ONE_PLY, MOVE_NONE, VALUE_ZERO);
+
+  tte = TT.probe(b, found);
+  check(found && tte->depth() == 8 * ONE_PLY, "second save through the same pointer is kept");
+  check(TT.probe(a, found) && found, "second save does not evict another position");
+
+  // A deeper position takes the first entry, the previous one moves down
+  TT.probe(c, found)->save(c, VALUE_ZERO, BOUND_EXACT, 12 * ONE_PLY, MOVE_NONE, VALUE_ZERO);
+
+  tte = TT.probe(c, found);
+  check(found && tte->depth() == 12 * ONE_PLY, "deeper position is stored");
+  tte = TT.probe(b, found);
+  check(found && tte->depth() == 8 * ONE_PLY && tte->value() == Value(50), "moved down entry keeps its result");
+  check(TT.probe(a, found) && found, "always-replace tier keeps the other position");
+
+  // A shallower position goes to the always-replace tier, the first entry stays
+  const Key d = key_in_cluster(0xDDDD);
+  TT.probe(d, found)->save(d, VALUE_ZERO, BOUND_EXACT, 2 * ONE_PLY, MOVE_NONE, VALUE_ZERO);
+
+  tte = TT.probe(c, found);
+  check(found && tte->depth() == 12 * ONE_PLY, "shallower position does not evict the first entry");
+  check(TT.probe(d, found) && found, "shallower position is stored");
+
+  std::cout << (failures ? "tt-test failed" : "tt-test passed") << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -20,6 +20,8 @@
 
 #include <algorithm> // For std::count
 #include <cassert>
+#include <iostream>
+#include <map>
 
 #include "movegen.h"
 #include "search.h"
@@ -30,6 +32,10 @@
 #endif
 #include "tt.h"
 
+#ifdef USE_NUMA_ALLOC
+#include <sys/mman.h>
+#endif
+
 #ifndef _WIN32
 void* run_idle_loop(void* thread) {
   static_cast<Thread*>(thread)->idle_loop();
@@ -57,12 +63,38 @@ Thread::Thread(size_t n) : idx(n) {
 #endif
 
 #ifndef __EMSCRIPTEN__
-  wait_for_search_finished();
-#endif
+  wait_for_search_finished(); // The thread clears its histories in idle_loop()
+#else
   clear(); // Zero-init histories (based on std::array)
+#endif
 }
 
 
+#ifdef USE_NUMA_ALLOC
+/// Thread::operator new() maps fresh pages for each Thread, so that the pages
+/// of the histories are placed on the node of the thread, that touches them
+/// first when clearing them in idle_loop(), and not where the pool lives.
+
+void* Thread::operator new(size_t size) {
+
+  void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (mem == MAP_FAILED)
+  {
+      std::cerr << "Failed to allocate " << size << " bytes for a thread." << std::endl;
+      ::exit(EXIT_FAILURE);
+  }
+
+  return mem;
+}
+
+void Thread::operator delete(void* mem, size_t size) {
+
+  munmap(mem, size);
+}
+#endif
+
+
 /// Thread destructor wakes up the thread in idle_loop() and waits
 /// for its termination. Thread should be already waiting.
 
@@ -130,7 +162,17 @@ void Thread::idle_loop() {
   // just check if running threads are below a threshold, in this case all this
   // NUMA machinery is not needed.
   if (Options["Threads"] > 8)
-      WinProcGroup::bindThisThread(idx);
+      boundNode = WinProcGroup::bindThisThread(idx);
+
+  // Once bound, recreate the pawn and material tables and zero the histories
+  // from here, so that with a first-touch policy they are local to the node.
+  if (boundNode != -1)
+  {
+      pawnsTable = Pawns::Table();
+      materialTable = Material::Table();
+  }
+
+  clear();
 
   while (true)
   {
@@ -148,29 +190,84 @@ void Thread::idle_loop() {
   }
 }
 
-/// ThreadPool::set() creates/destroys threads to match the requested number.
-/// Created and launched threads will go immediately to sleep in idle_loop.
-/// Upon resizing, threads are recreated to allow for binding if necessary.
+/// ThreadPool::wait_for_stop() blocks the calling thread, which is the main
+/// thread once its search is done, until the GUI sends "stop" or "ponderhit".
+/// It returns at once if we are neither pondering nor in an infinite search.
+
+void ThreadPool::wait_for_stop() {
+
+  std::unique_lock<Mutex> lk(stopMutex);
+  stopCv.wait(lk, [&]{ return stop || !(ponder || Search::Limits.infinite); });
+}
+
+
+/// ThreadPool::notify_stop() wakes up wait_for_stop(). It must be called after
+/// raising stop or resetting ponder. Taking the mutex first makes sure that the
+/// waiter is not between checking the flags and going to sleep.
+
+void ThreadPool::notify_stop() {
+
+  { std::lock_guard<Mutex> lk(stopMutex); }
+  stopCv.notify_all();
+}
+
+
+/// ThreadPool::set() grows or shrinks the pool to the requested number of
+/// threads. Threads no longer needed are parked, keeping their histories, and
+/// are the first to be reused when the pool grows again. Created and launched
+/// threads will go immediately to sleep in idle_loop. As threads are bound to
+/// NUMA nodes only when there are more than 8 of them, growing past that limit
+/// recreates all threads to allow for binding.
 
 void ThreadPool::set(size_t requested) {
 
-  if (size() > 0) { // destroy any existing thread(s)
+  if (size() > 0)
       main()->wait_for_search_finished();
 
+  if (requested == 0 || (requested > 8 && size() + parked.size() <= 8))
+  {
+      // Destroy any existing thread(s), parked ones included
       while (size() > 0)
           delete back(), pop_back();
+
+      while (parked.size() > 0)
+          delete parked.back(), parked.pop_back();
   }
 
-  if (requested > 0) { // create new thread(s)
-      push_back(new MainThread(0));
+  const bool created = empty() && requested > 0;
 
-      while (size() < requested)
-          push_back(new Thread(size()));
-      clear();
+  while (size() > requested)
+      parked.push_back(back()), pop_back();
+
+  while (size() < requested)
+  {
+      if (parked.size() > 0)
+          push_back(parked.back()), parked.pop_back();
+      else
+          push_back(empty() ? new MainThread(0) : new Thread(size()));
   }
 
-  // Reallocate the hash with the new threadpool size
-  TT.resize(Options["Hash"]);
+  if (created)
+  {
+      clear();
+
+      // Tell where the threads run, if they are bound to NUMA nodes
+      std::map<int, int> nodes;
+      for (Thread* th : *this)
+          if (th->boundNode != -1)
+              nodes[th->boundNode]++;
+
+      if (!nodes.empty())
+      {
+          sync_cout << "info string Thread binding:";
+          for (const auto& n : nodes)
+              std::cout << " node " << n.first << " " << n.second << " threads";
+          std::cout << sync_endl;
+      }
+
+      // Reallocate the hash with the new threadpool size
+      TT.resize(Options["Hash"]);
+  }
 }
 
 /// ThreadPool::clear() sets threadPool data to initial values.
@@ -180,6 +277,9 @@ void ThreadPool::clear() {
   for (Thread* th : *this)
       th->clear();
 
+  for (Thread* th : parked)
+      th->clear();
+
   main()->callsCnt = 0;
   main()->previousScore = VALUE_INFINITE;
   main()->previousTimeReduction = 1.0;
@@ -198,6 +298,14 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   stopOnPonderhit = stop = false;
   ponder = ponderMode;
   Search::Limits = limits;
+
+#ifndef __EMSCRIPTEN__
+  scheduler =  Options["SMP Scheduler"] == "None"        ? NO_SKIP
+             : Options["SMP Scheduler"] == "Depth Ratio" ? DEPTH_RATIO
+             : Options["SMP Scheduler"] == "ABDADA"      ? ABDADA
+                                                         : SKIP_BLOCKS;
+  depthRatio = Options["SMP Depth Ratio"];
+#endif
   Search::RootMoves rootMoves;
 
   for (const auto& m : MoveList<LEGAL>(pos))
@@ -227,6 +335,12 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   for (Thread* th : *this)
   {
       th->nodes = th->tbHits = th->nmpMinPly = 0;
+#ifdef TT_STATS
+      th->ttMoves = th->ttMoveRejects = th->ttProbes = th->ttHits = 0;
+#endif
+#if EVAL_CACHE_SIZE
+      th->evalProbes = th->evalHits = 0;
+#endif
       th->rootDepth = th->completedDepth = DEPTH_ZERO;
       th->rootMoves = rootMoves;
       th->rootPos.set(pos.fen(), pos.is_chess960(), pos.subvariant(), &setupStates->back(), th);
@@ -234,5 +348,9 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
 
   setupStates->back() = tmp;
 
+#ifdef ASYNC_YIELD
+  main()->nextYield = ASYNC_YIELD; // The node counts start over each search
+#endif
+
   main()->start_searching();
 }
@@ -21,6 +21,7 @@
 #ifndef THREAD_H_INCLUDED
 #define THREAD_H_INCLUDED
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
@@ -31,6 +32,7 @@
 #endif
 #include <vector>
 
+#include "evaluate.h"
 #include "material.h"
 #include "movepick.h"
 #include "pawns.h"
@@ -38,6 +40,12 @@
 #include "search.h"
 #include "thread_win32.h"
 
+#if defined(__linux__) && !defined(__ANDROID__) && !defined(__EMSCRIPTEN__)
+#define USE_NUMA_ALLOC
+#endif
+
+
+struct MainThread;
 
 /// Thread class keeps together all the thread-related stuff. We use
 /// per-thread pawn and material hash tables so that once we get a
@@ -59,6 +67,10 @@ class Thread {
 public:
   explicit Thread(size_t);
   virtual ~Thread();
+#ifdef USE_NUMA_ALLOC
+  static void* operator new(size_t size);
+  static void operator delete(void* mem, size_t size);
+#endif
   virtual void search();
   /* <REFACTORED FOR EMSCRIPTEN> */
   void search_iteration();
@@ -67,14 +79,22 @@ public:
   void idle_loop();
   void start_searching();
   void wait_for_search_finished();
+  bool is_searching() { std::lock_guard<Mutex> lk(mutex); return searching; }
 
   Pawns::Table pawnsTable;
   Material::Table materialTable;
+#if EVAL_CACHE_SIZE
+  Eval::Cache evalCache;
+  uint64_t evalProbes, evalHits;
+#endif
   Endgames endgames;
   size_t pvIdx, pvLast;
   int selDepth, nmpMinPly;
   Color nmpColor;
   std::atomic<uint64_t> nodes, tbHits;
+#ifdef TT_STATS
+  uint64_t ttMoves, ttMoveRejects, ttProbes, ttHits;
+#endif
 
   Position rootPos;
   Search::RootMoves rootMoves;
@@ -84,6 +104,21 @@ public:
   CapturePieceToHistory captureHistory;
   ContinuationHistory continuationHistory;
   Score contempt;
+  int boundNode = -1;
+  bool independent = false; // Searches its own root, as in batch analysis
+
+  // Root search state, carried from one iteration of search_iteration() to
+  // the next, so that each search is owned by its thread object.
+  Search::Stack stack[MAX_PLY+7], *ss = stack + 4; // To reference from (ss-4) and (ss+2)
+  Value bestValue, alpha, beta, delta;
+  Move lastBestMove;
+  Depth lastBestMoveDepth;
+  MainThread* mainThread;
+  double timeReduction;
+  size_t multiPV;
+  Search::Skill skill = Search::Skill(20);
+  bool failedLow;
+  Color us;
 };
 
 
@@ -103,6 +138,15 @@ struct MainThread : public Thread {
   double bestMoveChanges, previousTimeReduction;
   Value previousScore;
   int callsCnt;
+
+  // When each MultiPV line was last sent under the "Info Rate Limit" option, and
+  // whether an update was held back since the last final one
+  std::vector<TimePoint> lastInfo;
+  bool infoHeld = false;
+#ifdef ASYNC_YIELD
+  uint64_t nextYield;
+  bool yielding = false;
+#endif
 };
 
 
@@ -115,6 +159,8 @@ struct ThreadPool : public std::vector<Thread*> {
   void start_thinking(Position&, StateListPtr&, const Search::LimitsType&, bool = false);
   void clear();
   void set(size_t);
+  void wait_for_stop();
+  void notify_stop();
 
   MainThread* main()        const { return static_cast<MainThread*>(front()); }
   uint64_t nodes_searched() const { return accumulate(&Thread::nodes); }
@@ -122,8 +168,23 @@ struct ThreadPool : public std::vector<Thread*> {
 
   std::atomic_bool stop, ponder, stopOnPonderhit;
 
+  // How helper threads are spread across the iterations, see Thread::search_iteration()
+  enum Scheduler { SKIP_BLOCKS, NO_SKIP, DEPTH_RATIO, ABDADA };
+  Scheduler scheduler;
+  int depthRatio;
+
+  // Breadcrumbs are used to mark nodes as being searched by a given thread
+  struct Breadcrumb {
+    std::atomic<Thread*> thread;
+    std::atomic<Key> key;
+  };
+  std::array<Breadcrumb, 1024> breadcrumbs;
+
 private:
   StateListPtr setupStates;
+  std::vector<Thread*> parked; // Lowest index last
+  Mutex stopMutex;
+  ConditionVariable stopCv;
 
   uint64_t accumulate(std::atomic<uint64_t> Thread::* member) const {
 
@@ -18,8 +18,19 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define USE_HASH_FILE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <cstring>   // For std::memset
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <thread>
 
 #include "bitboard.h"
@@ -29,82 +40,401 @@
 
 TranspositionTable TT; // Our global transposition table
 
+namespace {
+
+  const char HashFileMagic[8] = { 'S', 'F', 'H', 'A', 'S', 'H', '0', '1' };
+  const char ExportMagic[8]   = { 'S', 'F', 'T', 'T', 'E', 'X', '0', '1' };
+
+  uint64_t fnv1a(const std::string& s) {
+
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : s)
+        h = (h ^ uint8_t(c)) * 1099511628211ULL;
+    return h;
+  }
+
+  // The position keys depend on the set of variants the engine is built with
+  uint64_t key_fingerprint() {
+
+    std::string id;
+    for (const std::string& v : variants)
+        id += " " + v;
+    return fnv1a(id);
+  }
+
+  // A hash file can only be reused by a build that lays out the table in the
+  // same way and computes the same position keys, i.e. one with the same set
+  // of variants. FNV-1a over a description of both is good enough for that.
+  // The layout of the variant regions is part of it too.
+  template<typename Cluster>
+  uint64_t fingerprint(int clusterSize, const std::string& layout) {
+
+    std::string id =  std::to_string(sizeof(Cluster)) + " "
+                    + std::to_string(clusterSize) + " "
+                    + std::to_string(Is64Bit);
+#ifdef LOCKLESS_TT
+    id += " lockless";
+#endif
+    for (const std::string& v : variants)
+        id += " " + v;
+
+    if (!layout.empty())
+        id += " partition" + layout;
+
+    return fnv1a(id);
+  }
+
+  // Header and records of the files written by TranspositionTable::export_file().
+  // Records keep 48 bits of the key: the 16 stored in the entry and the lowest
+  // 32 bits of the smallest key that maps to the entry's cluster. Those only
+  // map to the right cluster of a table whose cluster count divides the one of
+  // the exporting table. Records are written sorted by key, in native byte order.
+  struct ExportHeader {
+    char magic[8];
+    uint64_t keyFingerprint;
+    char variant[16];
+    uint64_t clusterCount;
+    uint64_t recordCount;
+  };
+
+  struct ExportRecord {
+    uint16_t key[3]; // Lowest 16 bits first
+    uint16_t move16;
+    int16_t  value16;
+    int16_t  eval16;
+    uint8_t  bound8;
+    int8_t   depth8;
+
+    Key full_key() const { return Key(key[2]) << 48 | Key(key[1]) << 16 | key[0]; }
+    bool operator<(const ExportRecord& r) const { return full_key() < r.full_key(); }
+  };
+
+  static_assert(sizeof(ExportRecord) == 14, "Export record size incorrect");
+
+#ifndef __EMSCRIPTEN__
+  // Reads the "Hash Partition" option, a list of variant:MB pairs separated
+  // by spaces or commas, e.g. "crazyhouse:64, atomic:32", into the size of
+  // the region of each variant. Returns the layout in a canonical form.
+  std::string parse_partition(size_t regionMB[]) {
+
+    std::string spec = Options["Hash Partition"], token, layout;
+
+    if (spec == "<empty>")
+        return layout;
+
+    std::replace(spec.begin(), spec.end(), ',', ' ');
+    std::istringstream ss(spec);
+
+    while (ss >> token)
+    {
+        size_t colon = token.find(':');
+        std::string name = token.substr(0, colon);
+        int mb = colon != std::string::npos ? std::atoi(token.c_str() + colon + 1) : 0;
+
+        if (std::find(variants.begin(), variants.end(), name) == variants.end() || mb <= 0)
+            sync_cout << "info string Ignoring hash partition " << token << sync_endl;
+        else
+            regionMB[UCI::variant_from_name(name)] = mb;
+    }
+
+    for (const std::string& name : variants)
+        if (regionMB[UCI::variant_from_name(name)])
+            layout += " " + name + ":" + std::to_string(regionMB[UCI::variant_from_name(name)]);
+
+    return layout;
+  }
+#endif
+
+} // namespace
+
 /// TTEntry::save saves a TTEntry
 void TTEntry::save(Key k, Value v, Bound b, Depth d, Move m, Value ev) {
 
   assert(d / ONE_PLY * ONE_PLY == d);
 
+  const uint16_t k16 = (uint16_t)(k >> 48), oldKey = key();
+
+  // With "Two-Tier" the first entry of a cluster is the depth-preferred tier.
+  // The search saves a node more than once through the pointer probe() gave
+  // it, so the position may have been moved up there by an earlier save.
+  TTEntry* first = nullptr;
+
+  if (TT.replacement == TranspositionTable::TWO_TIER)
+  {
+      first = &TranspositionTable::cluster_of(this)->entry[0];
+
+      if (first == this)
+          first = nullptr;
+
+      else if (first->key() == k16)
+      {
+          first->save(k, v, b, d, m, ev);
+          return;
+      }
+  }
+
   // Preserve any existing move for the same position
-  if (m || (k >> 48) != key16)
+  if (m || k16 != oldKey)
       move16 = (uint16_t)m;
 
   // Overwrite less valuable entries
-  if (  (k >> 48) != key16
+  if (   k16 != oldKey
       || d / ONE_PLY > depth8 - 4
-      || b == BOUND_EXACT)
+      || b == BOUND_EXACT
+      || TT.replacement == TranspositionTable::ALWAYS)
   {
-      key16     = (uint16_t)(k >> 48);
       value16   = (int16_t)v;
       eval16    = (int16_t)ev;
       genBound8 = (uint8_t)(TT.generation8 | b);
       depth8    = (int8_t)(d / ONE_PLY);
   }
+
+  // Store the key last, so that it covers all the fields written above
+#ifdef LOCKLESS_TT
+  key16 = k16 ^ check16();
+#else
+  key16 = k16;
+#endif
+
+  // The entry takes over the first one if it is at least as deep or that one
+  // is from an older search, which then moves down into the always-replace tier
+  if (first && (depth8 >= first->depth8 || (first->genBound8 & 0xFC) != TT.generation8))
+      std::swap(*this, *first);
 }
 
 
 /// TranspositionTable::resize() sets the size of the transposition table,
 /// measured in megabytes. Transposition table consists of a power of 2 number
 /// of clusters and each cluster consists of ClusterSize number of TTEntry.
+/// The table is backed by huge pages when available, and the backing we got
+/// is reported to the GUI whenever it changes. If a hash file is set, the
+/// table is mapped from it instead, reusing its content when compatible.
+/// Variants with a hash partition get their own region after the shared one,
+/// which has the given size.
 
 void TranspositionTable::resize(size_t mbSize) {
 
-  clusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
+  static LargePages::Backing lastReported = LargePages::NONE;
 
-  free(mem);
-  mem = malloc(clusterCount * sizeof(Cluster) + CacheLineSize - 1);
+  size_t regionMB[SUBVARIANT_NB] = {};
+  std::string layout;
+  bool mapped = false;
+
+#ifndef __EMSCRIPTEN__
+  layout = parse_partition(regionMB);
+#endif
 
-  if (!mem)
+  size_t sharedClusters = mbSize * 1024 * 1024 / sizeof(Cluster);
+
+  totalClusters = sharedClusters;
+  for (size_t mb : regionMB)
+      totalClusters += mb * 1024 * 1024 / sizeof(Cluster);
+
+  release();
+
+#ifndef __EMSCRIPTEN__
+  std::string fname = Options["Hash File"];
+
+  if (fname != "<empty>" && map_file(fname, layout))
+      mapped = true, lastReported = LargePages::NONE;
+  else
+      mem = LargePages::alloc(memSize = totalClusters * sizeof(Cluster) + CacheLineSize - 1,
+                              Options["Large Pages"], backing);
+#else
+  // Exiting would kill the page or worker running us, so settle for less and
+  // tell the GUI the size we got, as the "Hash" option keeps the requested one.
+  const size_t requestedMB = mbSize;
+
+  while (   !(mem = LargePages::alloc(memSize = totalClusters * sizeof(Cluster) + CacheLineSize - 1,
+                                      false, backing))
+         && mbSize > 1)
+  {
+      totalClusters -= sharedClusters;
+      sharedClusters = (mbSize /= 2) * 1024 * 1024 / sizeof(Cluster);
+      totalClusters += sharedClusters;
+  }
+
+  if (mem && mbSize < requestedMB)
+      sync_cout << "info string Failed to allocate " << requestedMB
+                << "MB for transposition table, using " << mbSize << "MB" << sync_endl;
+#endif
+
+  if (!mapped)
   {
-      std::cerr << "Failed to allocate " << mbSize
-                << "MB for transposition table." << std::endl;
-      exit(EXIT_FAILURE);
+      if (!mem)
+      {
+          std::cerr << "Failed to allocate " << mbSize
+                    << "MB for transposition table." << std::endl;
+          exit(EXIT_FAILURE);
+      }
+
+      if (backing != lastReported)
+      {
+          lastReported = backing;
+          sync_cout << "info string Hash table allocation: "
+                    << LargePages::name(backing) << sync_endl;
+      }
+
+      table = (Cluster*)((uintptr_t(mem) + CacheLineSize - 1) & ~(CacheLineSize - 1));
+      zero(table, totalClusters);
   }
 
-  table = (Cluster*)((uintptr_t(mem) + CacheLineSize - 1) & ~(CacheLineSize - 1));
-  clear();
+  // Lay out the regions, the shared one first
+  Cluster* next = table + sharedClusters;
+
+  regions[SUBVARIANT_NB] = { table, sharedClusters, 0 };
+
+  for (Variant v = CHESS_VARIANT; v < SUBVARIANT_NB; ++v)
+      if (regionMB[v])
+      {
+          regions[v] = { next, regionMB[v] * 1024 * 1024 / sizeof(Cluster), 0 };
+          next += regions[v].clusterCount;
+      }
+      else
+          regions[v] = { nullptr, 0, 0 };
+
+  if (!layout.empty())
+      sync_cout << "info string Hash partition:" << layout
+                << " shared:" << mbSize << sync_endl;
+
+  select(UCI::variant_from_name(Options["UCI_Variant"]));
 }
 
 
-/// TranspositionTable::clear() initializes the entire transposition table to zero,
-//  in a multi-threaded way.
+/// TranspositionTable::map_file() maps the table from the given file, so that
+/// its content survives engine restarts. The file is reused as is if its header
+/// matches the current table size and build, otherwise it is reinitialized.
+/// Returns false if the file cannot be mapped.
+
+bool TranspositionTable::map_file(const std::string& fname, const std::string& layout) {
+
+#ifdef USE_HASH_FILE
+  const size_t size = sizeof(FileHeader) + totalClusters * sizeof(Cluster);
+  const uint64_t fp = fingerprint<Cluster>(ClusterSize, layout);
+  struct stat st;
+
+  int fd = open(fname.c_str(), O_RDWR | O_CREAT, 0644);
+
+  if (fd == -1 || fstat(fd, &st) || (size_t(st.st_size) != size && ftruncate(fd, size)))
+  {
+      if (fd != -1)
+          close(fd);
+
+      sync_cout << "info string Could not open hash file " << fname << sync_endl;
+      return false;
+  }
+
+  void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (m == MAP_FAILED)
+  {
+      sync_cout << "info string Could not map hash file " << fname << sync_endl;
+      return false;
+  }
+
+  mem = m;
+  memSize = size;
+  header = (FileHeader*)mem;
+  table = (Cluster*)(header + 1);
+
+  bool reused =   size_t(st.st_size) == size
+               && !std::memcmp(header->magic, HashFileMagic, sizeof(HashFileMagic))
+               && header->fingerprint == fp
+               && header->clusterCount == totalClusters;
+
+  if (reused)
+      generation8 = header->generation8;
+  else
+  {
+      std::memset(header, 0, sizeof(FileHeader));
+      zero(table, totalClusters);
+      std::memcpy(header->magic, HashFileMagic, sizeof(HashFileMagic));
+      header->fingerprint = fp;
+      header->clusterCount = totalClusters;
+      header->generation8 = generation8;
+  }
+
+  sync_cout << "info string Hash table allocation: file " << fname
+            << (reused ? " (reused)" : " (initialized)") << sync_endl;
+
+  return true;
+#else
+  (void)layout;
+  sync_cout << "info string Hash file " << fname << " not supported on this platform" << sync_endl;
+  return false;
+#endif
+}
+
+
+/// TranspositionTable::release() frees or unmaps the memory of the table
+
+void TranspositionTable::release() {
+
+#ifdef USE_HASH_FILE
+  if (header)
+  {
+      munmap(mem, memSize);
+      header = nullptr;
+      mem = nullptr;
+      return;
+  }
+#endif
+
+  LargePages::free(mem, memSize, backing);
+  mem = nullptr;
+  backing = LargePages::NONE;
+}
+
+
+/// TranspositionTable::clear() empties the transposition table of the current
+/// variant by moving it to a new epoch, so that it takes constant time whatever
+/// the hash size. The clusters are zeroed for real only when the epoch wraps,
+/// and for a file backed table, whose epochs are not kept across restarts. With
+/// a hash partition the regions of other variants are kept.
 
 void TranspositionTable::clear() {
 
+  if (persistent() || ++current->epoch16 == 0)
+  {
+      current->epoch16 = 0;
+      zero(table, clusterCount);
+  }
+
+  epoch16 = current->epoch16;
+}
+
+
+/// TranspositionTable::zero() sets the given range of clusters to zero, in a
+/// multi-threaded way.
+
+void TranspositionTable::zero(Cluster* first, size_t count) {
+
 #ifndef __EMSCRIPTEN__
   std::vector<std::thread> threads;
 
   for (size_t idx = 0; idx < Options["Threads"]; idx++)
   {
-      threads.emplace_back([this, idx]() {
+      threads.emplace_back([first, count, idx]() {
 
           // Thread binding gives faster search on systems with a first-touch policy
           if (Options["Threads"] > 8)
               WinProcGroup::bindThisThread(idx);
 
           // Each thread will zero its part of the hash table
-          const size_t stride = clusterCount / Options["Threads"],
+          const size_t stride = count / Options["Threads"],
                        start  = stride * idx,
                        len    = idx != Options["Threads"] - 1 ?
-                                stride : clusterCount - start;
+                                stride : count - start;
 
-          std::memset(&table[start], 0, len * sizeof(Cluster));
+          std::memset(&first[start], 0, len * sizeof(Cluster));
       });
   }
 
   for (std::thread& th: threads)
       th.join();
 #else
-  std::memset(table, 0, clusterCount * sizeof(Cluster));
+  std::memset(first, 0, count * sizeof(Cluster));
 #endif // #ifndef __EMSCRIPTEN__
 }
 
@@ -117,32 +447,63 @@ void TranspositionTable::clear() {
 
 TTEntry* TranspositionTable::probe(const Key key, bool& found) const {
 
-  TTEntry* const tte = first_entry(key);
+  Cluster* const cl = cluster(key);
+  TTEntry* const tte = &cl->entry[0];
   const uint16_t key16 = key >> 48;  // Use the high 16 bits as key inside the cluster
 
+  // A cluster left from before the last clear() is empty
+  if (cl->epoch16 != epoch16)
+  {
+      std::memset(tte, 0, sizeof(cl->entry));
+      cl->epoch16 = epoch16;
+  }
+
   for (int i = 0; i < ClusterSize; ++i)
-      if (!tte[i].key16 || tte[i].key16 == key16)
+  {
+      const uint16_t k16 = tte[i].key();
+
+      if (!k16 || k16 == key16)
       {
           tte[i].genBound8 = uint8_t(generation8 | tte[i].bound()); // Refresh
 
-          return found = (bool)tte[i].key16, &tte[i];
+          return found = (bool)k16, &tte[i];
       }
+  }
 
   // Find an entry to be replaced according to the replacement strategy
   TTEntry* replace = tte;
   for (int i = 1; i < ClusterSize; ++i)
-      // Due to our packed storage format for generation and its cyclic
-      // nature we add 259 (256 is the modulus plus 3 to keep the lowest
-      // two bound bits from affecting the result) to calculate the entry
-      // age correctly even after generation8 overflows into the next cycle.
-      if (  replace->depth8 - ((259 + generation8 - replace->genBound8) & 0xFC) * 2
-          >   tte[i].depth8 - ((259 + generation8 -   tte[i].genBound8) & 0xFC) * 2)
+      if (replace_value(replace, int(replace - tte)) > replace_value(&tte[i], i))
           replace = &tte[i];
 
   return found = false, replace;
 }
 
 
+/// TranspositionTable::replace_value() returns how valuable the i-th entry of
+/// a cluster is under the current replacement policy; the least valuable entry
+/// gets replaced. The default policy uses the depth minus 8 times the relative
+/// age, "Depth" only the depth and "Always" only the age. "Two-Tier" never
+/// hands out the first entry, which only TTEntry::save() replaces by depth,
+/// and replaces the oldest of the others.
+
+int TranspositionTable::replace_value(const TTEntry* tte, int i) const {
+
+  // Due to our packed storage format for generation and its cyclic
+  // nature we add 259 (256 is the modulus plus 3 to keep the lowest
+  // two bound bits from affecting the result) to calculate the entry
+  // age correctly even after generation8 overflows into the next cycle.
+  const int age = (259 + generation8 - tte->genBound8) & 0xFC;
+
+  switch (replacement) {
+  case DEPTH:    return tte->depth8;
+  case ALWAYS:   return -age;
+  case TWO_TIER: return !i ? INT_MAX : -age;
+  default:       return tte->depth8 - age * 2;
+  }
+}
+
+
 /// TranspositionTable::hashfull() returns an approximation of the hashtable
 /// occupation during a search. The hash is x permill full, as per UCI protocol.
 
@@ -153,8 +514,95 @@ int TranspositionTable::hashfull() const {
   {
       const TTEntry* tte = &table[i].entry[0];
       for (int j = 0; j < ClusterSize; j++)
-          if ((tte[j].genBound8 & 0xFC) == generation8)
+          if ((tte[j].genBound8 & 0xFC) == generation8 && table[i].epoch16 == epoch16)
               cnt++;
   }
   return cnt;
 }
+
+
+/// TranspositionTable::export_file() writes the entries of the current variant
+/// with a depth of at least minDepth to the given file, so that import_file()
+/// can merge them into another session. Returns the number of entries written,
+/// or -1 if the file cannot be written.
+
+int TranspositionTable::export_file(const std::string& fname, Depth minDepth) const {
+
+  std::vector<ExportRecord> records;
+
+  for (size_t i = 0; i < clusterCount; ++i)
+  {
+      if (table[i].epoch16 != epoch16)
+          continue;
+
+      // Smallest 32 low bits of a key that first_entry() maps to this cluster
+      const uint32_t lo32 = uint32_t(((uint64_t(i) << 32) + clusterCount - 1) / clusterCount);
+
+      for (const TTEntry& tte : table[i].entry)
+          if (tte.key() && tte.depth() >= minDepth)
+              records.push_back({ { uint16_t(lo32), uint16_t(lo32 >> 16), tte.key() },
+                                  tte.move16, tte.value16, tte.eval16,
+                                  uint8_t(tte.bound()), tte.depth8 });
+  }
+
+  std::sort(records.begin(), records.end());
+
+  ExportHeader head = {};
+  std::memcpy(head.magic, ExportMagic, sizeof(ExportMagic));
+  head.keyFingerprint = key_fingerprint();
+  std::strncpy(head.variant, std::string(Options["UCI_Variant"]).c_str(), sizeof(head.variant) - 1);
+  head.clusterCount = clusterCount;
+  head.recordCount = records.size();
+
+  std::ofstream out(fname, std::ios::binary);
+  out.write((const char*)&head, sizeof(head));
+  out.write((const char*)records.data(), records.size() * sizeof(ExportRecord));
+
+  return out ? int(records.size()) : -1;
+}
+
+
+/// TranspositionTable::import_file() merges the entries of a file written by
+/// export_file() into the current table, which must have the same size or one
+/// whose cluster count divides the one of the exporting table. An entry
+/// replaces what is stored for the same position only if it is deeper. Returns
+/// the number of entries merged, -1 if the file cannot be read or is not for
+/// the current variant, or -2 if it does not fit the size of the table.
+
+int TranspositionTable::import_file(const std::string& fname) {
+
+  std::ifstream in(fname, std::ios::binary);
+  ExportHeader head;
+
+  if (!in.read((char*)&head, sizeof(head)))
+      return -1;
+
+  head.variant[sizeof(head.variant) - 1] = 0;
+
+  if (   std::memcmp(head.magic, ExportMagic, sizeof(ExportMagic))
+      || head.keyFingerprint != key_fingerprint()
+      || std::string(Options["UCI_Variant"]) != head.variant)
+      return -1;
+
+  if (head.clusterCount % clusterCount)
+      return -2;
+
+  int merged = 0;
+  ExportRecord r;
+
+  for (uint64_t n = 0; n < head.recordCount && in.read((char*)&r, sizeof(r)); ++n)
+  {
+      const Key key = r.full_key();
+      bool found;
+      TTEntry* tte = probe(key, found);
+
+      if (!found || tte->depth8 < r.depth8)
+      {
+          tte->save(key, Value(r.value16), Bound(r.bound8), Depth(r.depth8 * ONE_PLY),
+                    Move(r.move16), Value(r.eval16));
+          ++merged;
+      }
+  }
+
+  return merged;
+}
@@ -33,6 +33,11 @@
 /// generation  6 bit
 /// bound type  2 bit
 /// depth       8 bit
+///
+/// Entries are read and written by many threads without any locking. When
+/// compiled with LOCKLESS_TT the key is stored XORed with the other fields
+/// (except the generation, that probe() refreshes in place), so that an entry
+/// torn by concurrent writers no longer matches its key and reads as a miss.
 
 struct TTEntry {
 
@@ -46,6 +51,16 @@ struct TTEntry {
 private:
   friend class TranspositionTable;
 
+#ifdef LOCKLESS_TT
+  uint16_t check16() const {
+    return move16 ^ uint16_t(value16) ^ uint16_t(eval16)
+                  ^ uint16_t(uint8_t(depth8) << 8 | (genBound8 & 0x3));
+  }
+  uint16_t key() const { return key16 ^ check16(); }
+#else
+  uint16_t key() const { return key16; }
+#endif
+
   uint16_t key16;
   uint16_t move16;
   int16_t  value16;
@@ -55,45 +70,126 @@ private:
 };
 
 
+/// TTCluster is a bucket of as many TTEntry as fit in the given number of
+/// bytes, next to the epoch of the table clear the entries belong to. The
+/// geometry of the table is chosen at compile time by setting TT_CLUSTER_BYTES,
+/// e.g. 32 bytes for 3 entries (the default) or a full cache line of 64 bytes
+/// for 6 entries.
+
+template<int Bytes>
+struct alignas(Bytes) TTCluster { // Align to a divisor of the cache line size
+
+  static constexpr int Size = (Bytes - sizeof(uint16_t)) / sizeof(TTEntry);
+
+  TTEntry entry[Size];
+  uint16_t epoch16;
+};
+
+#ifndef TT_CLUSTER_BYTES
+#define TT_CLUSTER_BYTES 32
+#endif
+
+
 /// A TranspositionTable consists of a power of 2 number of clusters and each
 /// cluster consists of ClusterSize number of TTEntry. Each non-empty entry
 /// contains information of exactly one position. The size of a cluster should
 /// divide the size of a cache line size, to ensure that clusters never cross
 /// cache lines. This ensures best cache performance, as the cacheline is
 /// prefetched, as soon as possible.
+///
+/// The table can be split into regions, one for each variant listed in the
+/// "Hash Partition" option plus a shared one for all the others. Selecting a
+/// variant just points 'table' and 'clusterCount' at its region, so the hot
+/// path is the same as with a single table.
+///
+/// Clearing a region just moves it to a new epoch. A cluster of an older epoch
+/// counts as empty and is zeroed by the first probe() that touches it.
 
 class TranspositionTable {
 
   static constexpr int CacheLineSize = 64;
-  static constexpr int ClusterSize = 3;
 
-  struct Cluster {
-    TTEntry entry[ClusterSize];
-    char padding[2]; // Align to a divisor of the cache line size
-  };
+  typedef TTCluster<TT_CLUSTER_BYTES> Cluster;
+
+  static constexpr int ClusterSize = Cluster::Size;
 
   static_assert(CacheLineSize % sizeof(Cluster) == 0, "Cluster size incorrect");
 
+  // When the table is backed by a file (see the "Hash File" option) the file
+  // starts with this header, one cache line long so that clusters stay aligned.
+  struct FileHeader {
+    char magic[8];
+    uint64_t fingerprint;
+    uint64_t clusterCount;
+    uint8_t generation8;
+    char padding[CacheLineSize - 25];
+  };
+
+  static_assert(sizeof(FileHeader) == CacheLineSize, "File header size incorrect");
+
 public:
- ~TranspositionTable() { free(mem); }
-  void new_search() { generation8 += 4; } // Lower 2 bits are used by Bound
+  // Which entry of a full cluster probe() hands out for replacement
+  enum Replacement { DEPTH_AGE, DEPTH, ALWAYS, TWO_TIER };
+
+ ~TranspositionTable() { release(); }
+  void new_search() { // Lower 2 bits are used by Bound
+    generation8 += 4;
+    if (header)
+        header->generation8 = generation8;
+  }
   TTEntry* probe(const Key key, bool& found) const;
   int hashfull() const;
   void resize(size_t mbSize);
   void clear();
+  void select(Variant v) {
+    current = regions[v].table ? &regions[v] : &regions[SUBVARIANT_NB];
+    table = current->table, clusterCount = current->clusterCount, epoch16 = current->epoch16;
+  }
+  bool persistent() const { return header != nullptr; }
+  void set_replacement(Replacement r) { replacement = r; }
+  int export_file(const std::string& fname, Depth minDepth) const;
+  int import_file(const std::string& fname);
 
   // The 32 lowest order bits of the key are used to get the index of the cluster
   TTEntry* first_entry(const Key key) const {
-    return &table[(uint32_t(key) * uint64_t(clusterCount)) >> 32].entry[0];
+    return &cluster(key)->entry[0];
   }
 
 private:
   friend struct TTEntry;
 
+  struct Region {
+    Cluster* table;
+    size_t clusterCount;
+    uint16_t epoch16;
+  };
+
+  Cluster* cluster(const Key key) const {
+    return &table[(uint32_t(key) * uint64_t(clusterCount)) >> 32];
+  }
+
+  // Clusters are aligned to their size, so an entry tells its own cluster
+  static Cluster* cluster_of(TTEntry* tte) {
+    return (Cluster*)(uintptr_t(tte) & ~uintptr_t(sizeof(Cluster) - 1));
+  }
+
+  bool map_file(const std::string& fname, const std::string& layout);
+  void release();
+  void zero(Cluster* first, size_t count);
+  int replace_value(const TTEntry* tte, int i) const;
+
   size_t clusterCount;
   Cluster* table;
+  size_t totalClusters;
+  Region regions[SUBVARIANT_NB + 1]; // Partitioned variants, then the shared region
+  Region* current;
+  uint16_t epoch16;
   void* mem;
+  size_t memSize;
+  LargePages::Backing backing;
+  FileHeader* header;
   uint8_t generation8; // Size must be not bigger than TTEntry::genBound8
+  Replacement replacement;
 };
 
 extern TranspositionTable TT;
@@ -19,7 +19,10 @@
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -163,6 +166,7 @@ namespace {
         if (name == "uci_variant") {
             Variant variant = UCI::variant_from_name(value);
             sync_cout << "info string variant " << (string)Options["UCI_Variant"] << " startpos " << StartFENs[variant] << sync_endl;
+            TT.select(variant);
 #ifndef __EMSCRIPTEN__
             Tablebases::init(variant, Options["SyzygyPath"]);
 #endif
@@ -224,6 +228,206 @@ namespace {
   }
 
 
+  // savehash() is called when engine receives the "savehash" command, to write
+  // the hash entries of the current variant from the given depth on to a file.
+  // It is refused while a search is running, which would leave a partial snapshot.
+
+  void savehash(istringstream& is) {
+
+    string fname, token;
+    int depth = 1;
+
+    if (Threads.main()->is_searching())
+    {
+        sync_cout << "info string Stop the search before savehash" << sync_endl;
+        return;
+    }
+
+    is >> fname;
+    if (is >> token && token == "depth")
+        is >> depth;
+
+    int cnt = TT.export_file(fname, Depth(depth * ONE_PLY));
+
+    if (cnt < 0)
+        sync_cout << "info string Could not write " << fname << sync_endl;
+    else
+        sync_cout << "info string Saved " << cnt << " hash entries to " << fname << sync_endl;
+  }
+
+
+  // loadhash() is called when engine receives the "loadhash" command, to merge
+  // the hash entries saved by savehash into the current table. The entries only
+  // fit a table of the same size or a smaller one that divides it, and they are
+  // not written while the search threads are using the table.
+
+  void loadhash(istringstream& is) {
+
+    string fname;
+    is >> fname;
+
+    if (Threads.main()->is_searching())
+    {
+        sync_cout << "info string Stop the search before loadhash" << sync_endl;
+        return;
+    }
+
+    int cnt = TT.import_file(fname);
+
+    if (cnt == -2)
+        sync_cout << "info string Could not load " << fname
+                  << " (saved with a Hash size that is not a multiple of the current one)" << sync_endl;
+    else if (cnt < 0)
+        sync_cout << "info string Could not load " << fname
+                  << " (missing, or saved by another build or variant)" << sync_endl;
+    else
+        sync_cout << "info string Merged " << cnt << " hash entries from " << fname << sync_endl;
+  }
+
+
+#ifndef __EMSCRIPTEN__
+  // BatchWorker is a thread of the "analyse" command. Instead of helping the
+  // main thread on a shared root, it takes the next position from the batch
+  // each time it is done with one, searches it alone and prints the result.
+
+  struct BatchWorker : public Thread {
+
+    BatchWorker(size_t n, const vector<string>& f, std::atomic<size_t>& c)
+      : Thread(n), fens(f), cursor(c) { independent = true; }
+
+    void search() override {
+
+      size_t i;
+
+      while ((i = cursor++) < fens.size() && !Threads.stop)
+      {
+          StateInfo st;
+          rootPos.set(fens[i], Options["UCI_Chess960"],
+                      UCI::variant_from_name(Options["UCI_Variant"]), &st, this);
+
+          rootMoves.clear();
+          for (const auto& m : MoveList<LEGAL>(rootPos))
+              rootMoves.emplace_back(m);
+
+          nodes = tbHits = nmpMinPly = 0;
+          rootDepth = completedDepth = DEPTH_ZERO;
+
+          if (!rootMoves.empty())
+              Thread::search();
+
+          stringstream out;
+          out << "{\"fen\":\"" << fens[i] << "\",\"depth\":" << completedDepth / ONE_PLY
+              << ",\"nodes\":" << nodes;
+
+          if (!rootMoves.empty())
+          {
+              out << ",\"score\":\"" << UCI::value(rootMoves[0].score)
+                  << "\",\"bestmove\":\"" << UCI::move(rootMoves[0].pv[0], rootPos.is_chess960())
+                  << "\",\"pv\":\"";
+
+              for (size_t j = 0; j < rootMoves[0].pv.size(); ++j)
+                  out << (j ? " " : "") << UCI::move(rootMoves[0].pv[j], rootPos.is_chess960());
+
+              out << "\"";
+          }
+          else
+              out << ",\"bestmove\":\"(none)\"";
+
+          sync_cout << out.str() << "}" << sync_endl;
+          total += nodes;
+      }
+    }
+
+    const vector<string>& fens;
+    std::atomic<size_t>& cursor;
+    uint64_t total = 0;
+  };
+
+
+  // analyse() is called when engine receives the "analyse" command. It searches
+  // each position of an EPD file to the given depth, one position per thread,
+  // and prints a JSON line for each as soon as it is done. The positions are
+  // handed out one at a time, so that fast and slow ones even out. It is refused
+  // while a search started by "go" is running, which it would wait for.
+
+  void analyse(istringstream& is) {
+
+    string fname, token, line;
+    int depth = 12;
+    size_t threads = Options["Threads"];
+    vector<string> fens;
+
+    if (Threads.main()->is_searching())
+    {
+        sync_cout << "info string Stop the search before analyse" << sync_endl;
+        return;
+    }
+
+    is >> fname;
+    while (is >> token)
+        if (token == "depth")
+            is >> depth;
+        else if (token == "threads")
+            is >> threads;
+
+    ifstream file(fname);
+
+    if (!file.is_open())
+    {
+        sync_cout << "info string Could not open " << fname << sync_endl;
+        return;
+    }
+
+    // An EPD line starts with the first four FEN fields, optionally followed
+    // by the move counters, then by operations that we ignore.
+    while (getline(file, line))
+    {
+        istringstream ls(line);
+        string fen;
+
+        for (int f = 0; f < 6 && ls >> token; ++f)
+        {
+            if (f >= 4 && token.find_first_not_of("0123456789") != string::npos)
+                break;
+            fen += (f ? " " : "") + token;
+        }
+
+        if (!fen.empty() && fen[0] != '#')
+            fens.push_back(fen);
+    }
+
+    Threads.main()->wait_for_search_finished();
+    Threads.stop = false;
+    Search::Limits = Search::LimitsType();
+    Search::Limits.depth = depth;
+    Search::Limits.startTime = now();
+    TT.new_search();
+
+    std::atomic<size_t> cursor(0);
+    vector<BatchWorker*> workers;
+    TimePoint elapsed = now();
+    uint64_t nodes = 0;
+
+    for (size_t i = 0; i < std::max(threads, size_t(1)); ++i)
+        workers.push_back(new BatchWorker(i, fens, cursor));
+
+    for (BatchWorker* w : workers)
+        w->start_searching();
+
+    for (BatchWorker* w : workers)
+        w->wait_for_search_finished(), nodes += w->total, delete w;
+
+    elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+    cerr << "\n==========================="
+         << "\nPositions       : " << std::min(cursor.load(), fens.size())
+         << "\nTotal time (ms) : " << elapsed
+         << "\nNodes searched  : " << nodes
+         << "\nNodes/second    : " << 1000 * nodes / elapsed << endl;
+  }
+#endif
+
+
   // bench() is called when engine receives the "bench" command. Firstly
   // a list of UCI commands is setup according to bench parameters, then
   // it is run one by one printing a summary at the end.
@@ -233,6 +437,17 @@ namespace {
 
     string token;
     uint64_t num, nodes = 0, cnt = 1;
+#ifdef TT_STATS
+    uint64_t ttMoves = 0, ttMoveRejects = 0, ttProbes = 0, ttHits = 0;
+#endif
+#if EVAL_CACHE_SIZE
+    uint64_t evalProbes = 0, evalHits = 0;
+#endif
+    int hashfull = 0;
+
+    // Nodes and time per variant, for "bench all"
+    struct VariantStats { string name; uint64_t nodes; TimePoint time; };
+    vector<VariantStats> perVariant;
 
     vector<string> list = setup_bench(pos, args);
     num = count_if(list.begin(), list.end(), [](string s) { return s.find("go ") == 0; });
@@ -247,9 +462,24 @@ namespace {
         if (token == "go")
         {
             cerr << "\nPosition: " << cnt++ << '/' << num << endl;
+            TimePoint start = now();
             go(pos, is, states);
             Threads.main()->wait_for_search_finished();
             nodes += Threads.nodes_searched();
+            if (perVariant.empty() || perVariant.back().name != string(Options["UCI_Variant"]))
+                perVariant.push_back({Options["UCI_Variant"], 0, 0});
+            perVariant.back().nodes += Threads.nodes_searched();
+            perVariant.back().time += now() - start;
+            hashfull += TT.hashfull();
+#ifdef TT_STATS
+            for (Thread* th : Threads)
+                ttMoves += th->ttMoves, ttMoveRejects += th->ttMoveRejects,
+                ttProbes += th->ttProbes, ttHits += th->ttHits;
+#endif
+#if EVAL_CACHE_SIZE
+            for (Thread* th : Threads)
+                evalProbes += th->evalProbes, evalHits += th->evalHits;
+#endif
         }
         else if (token == "setoption")  setoption(is);
         else if (token == "position")   position(pos, is, states);
@@ -258,12 +488,42 @@ namespace {
 
     elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
 
+    size_t threadBytes =  sizeof(Thread) + Threads.main()->pawnsTable.size_in_bytes()
+                        + Threads.main()->materialTable.size_in_bytes();
+#if EVAL_CACHE_SIZE
+    threadBytes += Threads.main()->evalCache.size_in_bytes();
+#endif
+
     dbg_print(); // Just before exiting
 
     cerr << "\n==========================="
          << "\nTotal time (ms) : " << elapsed
          << "\nNodes searched  : " << nodes
-         << "\nNodes/second    : " << 1000 * nodes / elapsed << endl;
+         << "\nNodes/second    : " << 1000 * nodes / elapsed
+         << "\nHash full (avg) : " << hashfull / int(num ? num : 1) << " permill"
+#ifdef TT_STATS
+         << "\nTT move rejects : " << ttMoveRejects << " of " << ttMoves
+         << "\nTT hit rate     : " << 1000 * ttHits / std::max(ttProbes, uint64_t(1)) << " permill"
+         << "\nUnique nodes    : " << 1000 * (ttProbes - ttHits) / std::max(nodes, uint64_t(1)) << " permill"
+#endif
+         << "\nThread memory   : " << threadBytes / 1024 << " KB" << endl;
+
+#if EVAL_CACHE_SIZE
+    cerr << "Eval cache hits : " << 1000 * evalHits / std::max(evalProbes, uint64_t(1)) << " permill" << endl;
+#endif
+
+    // The size of the binary tells how much the compiled in variants cost
+    ifstream exe("/proc/self/exe", ios::binary | ios::ate);
+    if (exe.is_open())
+        cerr << "Binary size     : " << exe.tellg() / 1024 << " KB" << endl;
+
+    if (perVariant.size() > 1)
+    {
+        cerr << "\nNodes/second per variant:" << endl;
+        for (const VariantStats& v : perVariant)
+            cerr << "  " << std::left << std::setw(14) << v.name << ": "
+                 << 1000 * v.nodes / (v.time + 1) << endl;
+    }
   }
 #endif
 
@@ -293,7 +553,7 @@ void UCI::loop(int argc, char* argv[]) {
       if (argc == 1 && !getline(cin, cmd)) // Block here waiting for input or EOF
           cmd = "quit";
 #else
-extern "C" void uci_command(const char *c_cmd) {
+extern "C" int uci_command(const char *c_cmd) {
   static bool initialized = false;
   static Position pos;
   static StateListPtr states(new std::deque<StateInfo>(1));
@@ -311,6 +571,15 @@ extern "C" void uci_command(const char *c_cmd) {
       token.clear(); // Avoid a stale if getline() returns empty or blank line
       is >> skipws >> token;
 
+#ifdef ASYNC_YIELD
+      // While the search sleeps, only the commands that leave the search state
+      // alone may run. The others are sent again later, see post.js.
+      if (    Threads.main()->yielding
+          &&  token != "stop" && token != "ponderhit"
+          &&  token != "isready" && token != "uci")
+          return 1;
+#endif
+
       // The GUI sends 'ponderhit' to tell us the user has played the expected move.
       // So 'ponderhit' will be sent if we were told to ponder on the same move the
       // user has played. We should continue searching but switch from pondering to
@@ -319,10 +588,15 @@ extern "C" void uci_command(const char *c_cmd) {
       if (    token == "quit"
           ||  token == "stop"
           || (token == "ponderhit" && Threads.stopOnPonderhit))
+      {
           Threads.stop = true;
-
+          Threads.notify_stop();
+      }
       else if (token == "ponderhit")
+      {
           Threads.ponder = false; // Switch to normal search
+          Threads.notify_stop();
+      }
 
       else if (token == "uci")
           sync_cout << "id name " << engine_info(true)
@@ -339,13 +613,18 @@ extern "C" void uci_command(const char *c_cmd) {
       else if (token == "flip")  pos.flip();
 #ifndef __EMSCRIPTEN__
       else if (token == "bench") bench(pos, is, states);
+      else if (token == "analyse") analyse(is);
 #endif  // __EMSCRIPTEN__
+      else if (token == "savehash") savehash(is);
+      else if (token == "loadhash") loadhash(is);
       else if (token == "d")     sync_cout << pos << sync_endl;
       else if (token == "eval")  sync_cout << Eval::trace(pos) << sync_endl;
       else
           sync_cout << "Unknown command: " << cmd << sync_endl;
 #ifndef __EMSCRIPTEN__
   } while (token != "quit" && argc == 1); // Command line args are one-shot
+#else
+  return 0;
 #endif
 }
 
@@ -411,6 +690,33 @@ string UCI::move(Move m, bool chess960) {
 }
 
 
+#ifdef __EMSCRIPTEN__
+/// UCI::wire_move() packs a move for the info ring the way UCI::move() prints
+/// it: the destination in bits 0-5, the origin in bits 6-11, the promotion or
+/// dropped piece type in bits 12-14 and bit 15 set for a drop. The null move
+/// is 0.
+
+uint16_t UCI::wire_move(Move m, bool chess960) {
+
+  Square from = from_sq(m);
+  Square to = to_sq(m);
+
+  if (m == MOVE_NONE || m == MOVE_NULL)
+      return 0;
+
+  if (type_of(m) == CASTLING && !chess960)
+      to = make_square(to > from ? FILE_G : FILE_C, rank_of(from));
+
+#ifdef CRAZYHOUSE
+  if (type_of(m) == DROP)
+      return uint16_t(0x8000 | type_of(dropped_piece(m)) << 12 | int(to));
+#endif
+
+  return uint16_t((type_of(m) == PROMOTION ? promotion_type(m) << 12 : 0) | from << 6 | int(to));
+}
+#endif
+
+
 /// UCI::to_move() converts a string representing a move in coordinate notation
 /// (g1f3, a7a8q) to the corresponding legal Move, if any.
 
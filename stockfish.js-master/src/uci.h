@@ -74,7 +74,11 @@ void loop(int argc, char* argv[]);
 std::string value(Value v);
 std::string square(Square s);
 std::string move(Move m, bool chess960);
-std::string pv(const Position& pos, Depth depth, Value alpha, Value beta);
+std::string pv(const Position& pos, Depth depth, Value alpha, Value beta, bool final = false);
+#ifdef __EMSCRIPTEN__
+uint16_t wire_move(Move m, bool chess960);
+void pv_records(const Position& pos, Depth depth, Value alpha, Value beta, bool final = false);
+#endif
 Move to_move(const Position& pos, std::string& str);
 Variant variant_from_name(const std::string& str);
 
@@ -38,8 +38,19 @@ UCI::OptionsMap Options; // Global object
 namespace UCI {
 
 /// 'On change' actions, triggered by an option's value change
-void on_clear_hash(const Option&) { Search::clear(); }
+void on_clear_hash(const Option&) { Search::clear(); if (TT.persistent()) TT.clear(); }
 void on_hash_size(const Option& o) { TT.resize(o); }
+void on_hash_replacement(const Option& o) {
+  TT.set_replacement(  o == "Depth"    ? TranspositionTable::DEPTH
+                     : o == "Always"   ? TranspositionTable::ALWAYS
+                     : o == "Two-Tier" ? TranspositionTable::TWO_TIER
+                                       : TranspositionTable::DEPTH_AGE);
+}
+#ifndef __EMSCRIPTEN__
+void on_large_pages(const Option&) { TT.resize(Options["Hash"]); }
+void on_hash_file(const Option&) { TT.resize(Options["Hash"]); }
+void on_hash_partition(const Option&) { TT.resize(Options["Hash"]); }
+#endif
 void on_logger(const Option& o) { start_logger(o); }
 void on_threads(const Option& o) { Threads.set(o); }
 #ifndef  __EMSCRIPTEN__
@@ -62,6 +73,12 @@ void init(OptionsMap& o) {
 #ifndef __EMSCRIPTEN__
   // at most 2^32 clusters.
   constexpr int MaxHashMB = Is64Bit ? 131072 : 2048;
+#elif defined(JS_HEAP_MB)
+  // The heap cannot grow, and the rest of the engine needs room in it too
+  constexpr int MaxHashMB = JS_HEAP_MB / 2;
+#else
+  // The WASM heap is addressed with 32 bits, and grows on demand
+  constexpr int MaxHashMB = 2048;
 #endif
 
   o["Debug Log File"]        << Option("", on_logger);
@@ -69,11 +86,17 @@ void init(OptionsMap& o) {
   o["Analysis Contempt"]     << Option("Both", {"Both", "Off", "White", "Black"});
 #ifndef __EMSCRIPTEN__
   o["Threads"]               << Option(1, 1, 512, on_threads);
+  o["SMP Scheduler"]         << Option("Skip Blocks", {"Skip Blocks", "None", "Depth Ratio", "ABDADA"});
+  o["SMP Depth Ratio"]       << Option(50, 1, 100);
   o["Hash"]                  << Option(16, 1, MaxHashMB, on_hash_size);
+  o["Large Pages"]           << Option(true, on_large_pages);
+  o["Hash File"]             << Option("<empty>", on_hash_file);
+  o["Hash Partition"]        << Option("<empty>", on_hash_partition);
 #else
   o["Threads"]               << Option(1, 1, 1, on_threads);
-  o["Hash"]                  << Option(16, 16, 16, on_hash_size);
+  o["Hash"]                  << Option(std::min(16, MaxHashMB), 1, MaxHashMB, on_hash_size);
 #endif
+  o["Hash Replacement"]      << Option("Depth-Age", {"Depth-Age", "Depth", "Always", "Two-Tier"}, on_hash_replacement);
   o["Clear Hash"]            << Option(on_clear_hash);
   o["Ponder"]                << Option(false);
   o["MultiPV"]               << Option(1, 1, 500);
@@ -85,6 +108,11 @@ void init(OptionsMap& o) {
   o["UCI_Chess960"]          << Option(false);
   o["UCI_Variant"]           << Option(variants.front().c_str(), variants);
   o["UCI_AnalyseMode"]       << Option(false);
+  o["Info Format"]           << Option("UCI", {"UCI", "JSON"});
+  o["Info Rate Limit"]       << Option(0, 0, 1000);
+#ifdef __EMSCRIPTEN__
+  o["Binary Info"]           << Option(false);
+#endif
 #ifndef __EMSCRIPTEN__
   o["SyzygyPath"]            << Option("<empty>", on_tb_path);
   o["SyzygyProbeDepth"]      << Option(1, 1, 100);
@@ -0,0 +1,108 @@
+#!/usr/bin/env node
+
+/// Measures how long the engine takes to answer "stop" with "bestmove".
+///
+/// Starts an infinite search several times, sends "stop" after a random delay
+/// and reports the time until the best move arrives. In the single-threaded JS
+/// builds this is bounded by the time the search runs between two yields to
+/// the event loop (see the jsyield flag in the Makefile).
+///
+/// Usage: node stop_latency.js [engine] [--runs=20] [--min=500] [--max=3000]
+
+"use strict";
+
+var spawn = require("child_process").spawn;
+var p = require("path");
+
+var enginePath = p.join(__dirname, "src", "stockfish.js");
+var runs = 20;
+var minDelay = 500;
+var maxDelay = 3000;
+var fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10";
+
+process.argv.slice(2).forEach(function (arg)
+{
+    var match = arg.match(/^--(\w+)=(.*)$/);
+
+    if (!match) {
+        enginePath = arg;
+    } else if (match[1] === "runs") {
+        runs = Number(match[2]);
+    } else if (match[1] === "min") {
+        minDelay = Number(match[2]);
+    } else if (match[1] === "max") {
+        maxDelay = Number(match[2]);
+    }
+});
+
+var engine = spawn(enginePath.slice(-3).toLowerCase() === ".js" ? process.execPath : enginePath,
+                   enginePath.slice(-3).toLowerCase() === ".js" ? [enginePath] : [],
+                   {stdio: "pipe"});
+var buffer = "";
+var latencies = [];
+var stopSent;
+
+function write(str)
+{
+    engine.stdin.write(str + "\n");
+}
+
+function start_search()
+{
+    if (latencies.length >= runs) {
+        report();
+        write("quit");
+        return;
+    }
+
+    stopSent = 0;
+    write("ucinewgame");
+    write("position fen " + fen);
+    write("go infinite");
+
+    setTimeout(function ()
+    {
+        stopSent = Date.now();
+        write("stop");
+    }, minDelay + Math.random() * (maxDelay - minDelay));
+}
+
+function report()
+{
+    var sorted = latencies.slice().sort(function (a, b)
+    {
+        return a - b;
+    });
+
+    console.log("runs " + sorted.length +
+                "  min " + sorted[0] + " ms" +
+                "  median " + sorted[Math.floor(sorted.length / 2)] + " ms" +
+                "  max " + sorted[sorted.length - 1] + " ms");
+}
+
+engine.stdout.on("data", function ondata(data)
+{
+    var lines = (buffer + data.toString()).split("\n");
+
+    buffer = lines.pop();
+
+    lines.forEach(function (line)
+    {
+        if (line === "uciok") {
+            start_search();
+        } else if (line.indexOf("bestmove") === 0) {
+            if (!stopSent) {
+                throw new Error("bestmove before stop: " + line);
+            }
+            latencies.push(Date.now() - stopSent);
+            start_search();
+        }
+    });
+});
+
+engine.on("error", function (err)
+{
+    throw err;
+});
+
+write("uci");
@@ -0,0 +1,71 @@
+#!/usr/bin/env node
+
+/// Stress test for the transposition table under many threads.
+///
+/// Runs the native engine's bench at several thread counts and reports the
+/// speed together with the share of TT moves that were rejected as invalid
+/// in the position they were probed for. Those come from key collisions and
+/// from entries torn by concurrent writers, so comparing a normal build with
+/// one made with "make build lockless=yes" shows the torn read rate and what
+/// the checksum costs. The engines must be built with "ttstats=yes", which
+/// makes the bench count the rejected TT moves.
+///
+/// Usage: node tt_stress.js [engine...] [--threads=1,8,64] [--hash=256] [--depth=16]
+
+"use strict";
+
+var spawnSync = require("child_process").spawnSync;
+var p = require("path");
+
+var engines = [];
+var threads = [1, 8, 64];
+var hash = 256;
+var depth = 16;
+
+process.argv.slice(2).forEach(function (arg)
+{
+    var match = arg.match(/^--(\w+)=(.*)$/);
+
+    if (!match) {
+        engines.push(arg);
+    } else if (match[1] === "threads") {
+        threads = match[2].split(",").map(Number);
+    } else if (match[1] === "hash") {
+        hash = Number(match[2]);
+    } else if (match[1] === "depth") {
+        depth = Number(match[2]);
+    }
+});
+
+if (!engines.length) {
+    engines.push(p.join(__dirname, "src", "stockfish"));
+}
+
+function run_bench(engine, threadCount)
+{
+    ///NOTE: The "bench" command sends the final result in stderr.
+    var out = spawnSync(engine, ["bench", String(hash), String(threadCount), String(depth), "default", "depth"]).stderr.toString(),
+        nps = out.match(/Nodes\/second\s*:\s*(\d+)/),
+        rejects = out.match(/TT move rejects\s*:\s*(\d+) of (\d+)/);
+
+    return {
+        nps: nps ? Number(nps[1]) : 0,
+        rejects: rejects ? Number(rejects[1]) : 0,
+        ttMoves: rejects ? Number(rejects[2]) : 0
+    };
+}
+
+engines.forEach(function (engine)
+{
+    console.log(engine);
+
+    threads.forEach(function (threadCount)
+    {
+        var res = run_bench(engine, threadCount);
+
+        console.log("  threads " + threadCount +
+                    "  nps " + res.nps +
+                    "  rejected TT moves " + res.rejects + "/" + res.ttMoves +
+                    " (" + (res.ttMoves ? (1e6 * res.rejects / res.ttMoves).toFixed(1) : "0") + " ppm)");
+    });
+});